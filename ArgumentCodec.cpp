@@ -0,0 +1,139 @@
+#include "ArgumentCodec.h"
+
+#include <variant>
+#include <vector>
+
+namespace {
+
+    using TaggedValue = std::variant<bool, char, long long, unsigned long long, float, double, std::string_view, const void*>;
+
+    template <typename T>
+    bool readValue(const std::byte*& data, const std::byte* end, TaggedValue& value) {
+        if (end - data < static_cast<std::ptrdiff_t>(sizeof(T))) {
+            return false;
+        }
+        T raw;
+        std::memcpy(&raw, data, sizeof(raw));
+        data += sizeof(raw);
+        value = raw;
+        return true;
+    }
+
+    /**
+     * @brief Decodes every tagged argument in [data, end).
+     * @return false if the data is truncated or has an unknown tag.
+     */
+    bool decodeTagged(const std::byte* data, const std::byte* end, std::vector<TaggedValue>& values) {
+        while (data < end) {
+            ArgumentType type = static_cast<ArgumentType>(*data++);
+            TaggedValue value;
+            bool ok = false;
+            switch (type) {
+            case ArgumentType::Bool: ok = readValue<bool>(data, end, value); break;
+            case ArgumentType::Char: ok = readValue<char>(data, end, value); break;
+            case ArgumentType::Int64: ok = readValue<long long>(data, end, value); break;
+            case ArgumentType::UInt64: ok = readValue<unsigned long long>(data, end, value); break;
+            case ArgumentType::Float: ok = readValue<float>(data, end, value); break;
+            case ArgumentType::Double: ok = readValue<double>(data, end, value); break;
+            case ArgumentType::Pointer: ok = readValue<const void*>(data, end, value); break;
+            case ArgumentType::String: {
+                std::uint32_t length;
+                if (end - data < static_cast<std::ptrdiff_t>(sizeof(length))) {
+                    return false;
+                }
+                std::memcpy(&length, data, sizeof(length));
+                data += sizeof(length);
+                if (end - data < static_cast<std::ptrdiff_t>(length)) {
+                    return false;
+                }
+                value = std::string_view(reinterpret_cast<const char*>(data), length);
+                data += length;
+                ok = true;
+                break;
+            }
+            }
+            if (!ok) {
+                return false;
+            }
+            values.push_back(value);
+        }
+        return true;
+    }
+
+}
+
+/**
+ * @brief Formats self-describing encoded arguments without knowing their C++ types.
+ * Used where the producer's formatter is not available, such as the offline
+ * decoder. Each replacement field is formatted on its own with its format
+ * spec; nested replacement fields (dynamic width/precision) are not supported
+ * and are copied through unformatted.
+ * @param out Receives the formatted text.
+ * @param format The format string the arguments were captured for.
+ * @param data The encoded arguments.
+ * @param size Number of encoded bytes.
+ */
+void ArgumentCodec::formatTagged(std::string& out, std::string_view format, const std::byte* data, std::size_t size) {
+    std::vector<TaggedValue> values;
+    if (!decodeTagged(data, data + size, values)) {
+        out += "<corrupt arguments> ";
+    }
+
+    std::size_t nextIndex = 0;
+    std::string field;
+    for (std::size_t i = 0; i < format.size(); ++i) {
+        char c = format[i];
+        if (c == '}') {
+            if (i + 1 < format.size() && format[i + 1] == '}') {
+                ++i;
+            }
+            out += '}';
+            continue;
+        }
+        if (c != '{') {
+            out += c;
+            continue;
+        }
+        if (i + 1 < format.size() && format[i + 1] == '{') {
+            out += '{';
+            ++i;
+            continue;
+        }
+
+        std::size_t close = format.find('}', i + 1);
+        if (close == std::string_view::npos) {
+            out.append(format.substr(i));
+            break;
+        }
+        std::string_view replacement = format.substr(i + 1, close - i - 1);
+        std::size_t colon = replacement.find(':');
+        std::string_view id = replacement.substr(0, colon);
+        std::string_view spec = colon == std::string_view::npos ? std::string_view() : replacement.substr(colon);
+
+        std::size_t index = nextIndex++;
+        if (!id.empty()) {
+            index = 0;
+            for (char digit : id) {
+                index = index * 10 + static_cast<std::size_t>(digit - '0');
+            }
+        }
+
+        if (index >= values.size() || spec.find('{') != std::string_view::npos) {
+            out.append(format.substr(i, close - i + 1));
+        }
+        else {
+            field.assign("{");
+            field += spec;
+            field += '}';
+            try {
+                std::visit([&](const auto& value) {
+                    std::vformat_to(std::back_inserter(out), field, std::make_format_args(value));
+                    }, values[index]);
+            }
+            catch (const std::format_error&) {
+                out.append(format.substr(i, close - i + 1));
+            }
+        }
+        i = close;
+    }
+}
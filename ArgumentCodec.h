@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+enum class ArgumentType : std::uint8_t {
+    Bool,
+    Char,
+    Int64,
+    UInt64,
+    Float,
+    Double,
+    String,
+    Pointer
+};
+
+/**
+ * @brief Binary encoding of format arguments for deferred formatting.
+ * Every argument is stored as a one-byte ArgumentType tag followed by its raw
+ * value (strings as a 32-bit length and their characters), so a record can be
+ * formatted later, on another thread or by an offline tool, without the
+ * producer paying for text conversion.
+ */
+class ArgumentCodec {
+public:
+    using Formatter = void (*)(std::string& out, std::string_view format, const std::byte* data);
+
+    /**
+     * @brief True if every argument type can be captured in binary form.
+     * Other types (e.g. user types with a std::formatter) are formatted eagerly.
+     */
+    template <typename... Args>
+    static constexpr bool canEncode() {
+        return (isEncodable<std::remove_cvref_t<Args>>() && ...);
+    }
+
+    template <typename... Args>
+    static std::size_t encodedSize(const Args&... args) {
+        return (sizeOf(args) + ... + 0);
+    }
+
+    template <typename... Args>
+    static void encode(std::byte* out, const Args&... args) {
+        ((out = write(out, args)), ...);
+    }
+
+    /**
+     * @brief Decodes arguments encoded for Args and formats them with std::vformat_to.
+     * A pointer to an instantiation of this function travels with each deferred
+     * record, so the writer formats with exactly the producer's types.
+     */
+    template <typename... Args>
+    static void formatEncoded(std::string& out, std::string_view format, const std::byte* data) {
+        std::tuple<Stored<std::remove_cvref_t<Args>>...> values{ read<Stored<std::remove_cvref_t<Args>>>(data)... };
+        std::apply([&](auto&... value) {
+            std::vformat_to(std::back_inserter(out), format, std::make_format_args(value...));
+            }, values);
+    }
+
+    static void formatTagged(std::string& out, std::string_view format, const std::byte* data, std::size_t size);
+
+private:
+    template <typename T>
+    static constexpr bool isString() {
+        return std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>
+            || std::is_same_v<T, const char*> || std::is_same_v<T, char*>
+            || (std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>);
+    }
+
+    template <typename T>
+    static constexpr bool isEncodable() {
+        return std::is_arithmetic_v<T> || isString<T>() || std::is_pointer_v<T> || std::is_null_pointer_v<T>;
+    }
+
+    // Decoded representation of an argument of type T
+    template <typename T>
+    using Stored = std::conditional_t<isString<T>(), std::string_view,
+        std::conditional_t<std::is_same_v<T, bool>, bool,
+        std::conditional_t<std::is_same_v<T, char>, char,
+        std::conditional_t<std::is_same_v<T, float>, float,
+        std::conditional_t<std::is_floating_point_v<T>, double,
+        std::conditional_t<std::is_pointer_v<T> || std::is_null_pointer_v<T>, const void*,
+        std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>>>>>>>;
+
+    template <typename T>
+    static constexpr ArgumentType typeOf() {
+        using S = Stored<T>;
+        if constexpr (std::is_same_v<S, std::string_view>) return ArgumentType::String;
+        else if constexpr (std::is_same_v<S, bool>) return ArgumentType::Bool;
+        else if constexpr (std::is_same_v<S, char>) return ArgumentType::Char;
+        else if constexpr (std::is_same_v<S, float>) return ArgumentType::Float;
+        else if constexpr (std::is_same_v<S, double>) return ArgumentType::Double;
+        else if constexpr (std::is_same_v<S, const void*>) return ArgumentType::Pointer;
+        else if constexpr (std::is_same_v<S, long long>) return ArgumentType::Int64;
+        else return ArgumentType::UInt64;
+    }
+
+    template <typename T>
+    static std::string_view asString(const T& value) {
+        if constexpr (std::is_pointer_v<T>) {
+            return value != nullptr ? std::string_view(value) : std::string_view();
+        }
+        else {
+            return std::string_view(value);
+        }
+    }
+
+    template <typename T>
+    static std::size_t sizeOf(const T& value) {
+        if constexpr (isString<T>()) {
+            return 1 + sizeof(std::uint32_t) + asString(value).size();
+        }
+        else {
+            return 1 + sizeof(Stored<T>);
+        }
+    }
+
+    template <typename T>
+    static std::byte* write(std::byte* out, const T& value) {
+        *out++ = static_cast<std::byte>(typeOf<T>());
+        if constexpr (isString<T>()) {
+            std::string_view text = asString(value);
+            std::uint32_t length = static_cast<std::uint32_t>(text.size());
+            std::memcpy(out, &length, sizeof(length));
+            std::memcpy(out + sizeof(length), text.data(), text.size());
+            return out + sizeof(length) + text.size();
+        }
+        else {
+            Stored<T> stored = static_cast<Stored<T>>(value);
+            std::memcpy(out, &stored, sizeof(stored));
+            return out + sizeof(stored);
+        }
+    }
+
+    template <typename S>
+    static S read(const std::byte*& data) {
+        ++data; // type tag
+        if constexpr (std::is_same_v<S, std::string_view>) {
+            std::uint32_t length;
+            std::memcpy(&length, data, sizeof(length));
+            std::string_view text(reinterpret_cast<const char*>(data + sizeof(length)), length);
+            data += sizeof(length) + length;
+            return text;
+        }
+        else {
+            S value;
+            std::memcpy(&value, data, sizeof(value));
+            data += sizeof(value);
+            return value;
+        }
+    }
+};
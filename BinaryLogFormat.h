@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Layout of log files written with "format": "binary".
+ * A file starts with an 8-byte magic followed by a sequence of records. A
+ * format definition record assigns an id to a format string; message records
+ * that follow refer to it and carry their arguments as encoded by
+ * ArgumentCodec. Format id 0 means the payload is plain message text.
+ * Definitions may be repeated (e.g. after the logger resumes a file); each one
+ * applies to the records after it. All fields are little-endian.
+ */
+struct BinaryLogFormat {
+    static constexpr char magic[8] = { 'C', 'L', 'O', 'G', 'B', 'I', 'N', '1' };
+
+    enum RecordType : std::uint8_t {
+        FormatDefinition = 1,
+        Message = 2
+    };
+
+    struct FormatHeader {
+        std::uint8_t type;
+        std::uint8_t reserved[3];
+        std::uint32_t formatId;
+        std::uint32_t length;      // bytes of format string that follow
+    };
+
+    struct MessageHeader {
+        std::uint8_t type;
+        std::uint8_t level;        // LogLevel
+        std::uint16_t reserved;
+        std::uint32_t threadId;
+        std::int64_t timeMicros;   // microseconds since the Unix epoch
+        std::uint32_t formatId;
+        std::uint32_t payloadLength;
+    };
+
+    static_assert(sizeof(FormatHeader) == 12, "FormatHeader must not contain padding");
+    static_assert(sizeof(MessageHeader) == 24, "MessageHeader must not contain padding");
+
+    static constexpr std::size_t formatIdOffset = offsetof(MessageHeader, formatId);
+
+    static void appendFormatDefinition(std::string& out, std::uint32_t formatId, std::string_view format) {
+        FormatHeader header{ FormatDefinition, { 0, 0, 0 }, formatId, static_cast<std::uint32_t>(format.size()) };
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.append(format);
+    }
+
+    static void appendMessageHeader(std::string& out, std::uint8_t level, std::uint32_t threadId,
+        std::int64_t timeMicros, std::uint32_t formatId, std::size_t payloadLength) {
+        MessageHeader header{ Message, level, 0, threadId, timeMicros, formatId, static_cast<std::uint32_t>(payloadLength) };
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free queue based on Dmitry Vyukov's sequence-numbered ring.
+ * Any number of threads may push. Popping is safe from several threads as well,
+ * which lets a producer discard the oldest element when the queue is full, but
+ * the logger only has a single regular consumer: its writer thread.
+ * Elements are constructed once up front and reused; tryPush/tryPop hand the
+ * caller a reference to the slot so records are filled and read in place.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    /**
+     * @param capacity Requested number of slots, rounded up to a power of two.
+     */
+    explicit BoundedQueue(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask = size - 1;
+        cells = std::make_unique<Cell[]>(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @param capacity Requested number of slots, rounded up to a power of two.
+     * @param init Called once with every element, e.g. to hand it a shared resource.
+     */
+    template <typename Init>
+    BoundedQueue(std::size_t capacity, Init&& init) : BoundedQueue(capacity) {
+        for (std::size_t i = 0; i <= mask; ++i) {
+            init(cells[i].value);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Claims a free slot and lets fill(T&) write the element into it.
+     * @return false if the queue is full; fill is not called in that case.
+     */
+    template <typename Fill>
+    bool tryPush(Fill&& fill) {
+        Cell* cell;
+        std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        fill(cell->value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Takes the oldest published element and passes it to consume(T&).
+     * @return false if no element is available.
+     */
+    template <typename Consume>
+    bool tryPop(Consume&& consume) {
+        Cell* cell;
+        std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        consume(cell->value);
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Approximate emptiness check; a slot may be claimed but not yet published.
+     */
+    bool empty() const {
+        return enqueuePos.load(std::memory_order_seq_cst) == dequeuePos.load(std::memory_order_seq_cst);
+    }
+
+    /**
+     * @brief Approximate number of queued elements.
+     */
+    std::size_t size() const {
+        std::size_t head = dequeuePos.load(std::memory_order_relaxed);
+        std::size_t tail = enqueuePos.load(std::memory_order_relaxed);
+        return tail >= head ? tail - head : 0;
+    }
+
+    std::size_t capacity() const { return mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    static constexpr std::size_t cacheLineSize = 64;
+
+    std::unique_ptr<Cell[]> cells;
+    std::size_t mask = 0;
+    alignas(cacheLineSize) std::atomic<std::size_t> enqueuePos{ 0 };
+    alignas(cacheLineSize) std::atomic<std::size_t> dequeuePos{ 0 };
+};
@@ -4,44 +4,861 @@
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
+namespace {
+
+    // Per-thread scratch space used to build a line before it is written. The
+    // buffers are sized for typical lines when a thread first logs, so they
+    // rarely have to grow, and then keep their capacity for the thread's lifetime.
+    struct LineStaging {
+        static constexpr std::size_t initialBytes = 1024;
+
+        TimestampCache timestamps;
+        std::string line;
+        std::string message;
+        std::string definition;
+        std::string fields;
+
+        LineStaging() {
+            line.reserve(initialBytes);
+            message.reserve(initialBytes);
+            fields.reserve(initialBytes);
+        }
+    };
+
+    thread_local LineStaging staging;
+
+    // A log time truncated to the precision its timestamp is printed with, which is what a search reads back
+    std::int64_t printedMicros(std::chrono::system_clock::time_point time, TimestampPrecision precision) {
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+        switch (precision) {
+        case TimestampPrecision::Seconds: return micros - micros % 1000000;
+        case TimestampPrecision::Milliseconds: return micros - micros % 1000;
+        default: return micros;
+        }
+    }
+
+}
+
 /**
  * @brief Constructor for CircularLogger. Initializes the logger by loading configuration
  * and ensuring the log directory exists.
  * @param configPath Path to the configuration JSON file.
  */
-CircularLogger::CircularLogger(const std::string& configPath) : configPath(configPath) {
+CircularLogger::CircularLogger(const std::string& configPath) : CircularLogger(configPath, LoggerContext{}) {
+}
+
+/**
+ * @brief Constructor for a logger that uses the writer and housekeeping
+ * threads of its owner, such as a LoggerRegistry channel.
+ * @param configPath Path to the configuration JSON file.
+ * @param context Shared workers; for each one left null the logger starts its own.
+ */
+CircularLogger::CircularLogger(const std::string& configPath, const LoggerContext& context)
+    : configPath(configPath), logDirectory(context.defaultLogDirectory), housekeeper(context.housekeeper) {
+    if (housekeeper == nullptr) {
+        ownHousekeeper = std::make_unique<Housekeeper>();
+        housekeeper = ownHousekeeper.get();
+    }
     loadConfig();
+    if (context.clock != nullptr) {
+        clock = LogClock(context.clock);
+    }
     ensureLogDirectory();
+    fileWriter = LogFileWriter::create(writerOptions);
+    if (networkOptions.protocol != NetworkProtocol::None) {
+        if (logFormat == LogFormat::Binary) {
+            std::cerr << "networkProtocol is ignored with \"format\": \"binary\", only text and JSON lines are shipped" << std::endl;
+        }
+        else {
+            networkOptions.spillPath = fs::path(logDirectory) / "network.spill";
+            networkSink = std::make_unique<NetworkSink>(networkOptions);
+        }
+    }
+    // Binary files are not indexed, reading them from a checkpoint would miss the format definitions before it
+    indexing = indexCheckpointBytes > 0 && logFormat != LogFormat::Binary;
+    if (indexing) {
+        logIndex.configure(indexCheckpointBytes, indexBloomBytes);
+    }
+    loadRetainedFiles();
+    if (mode == LoggingMode::Async) {
+        if (recordSlabCount > 0) {
+            recordSlabs = std::make_unique<SlabPool>(std::max(recordSlabBytes, LogRecord::inlineCapacity), recordSlabCount);
+        }
+        queue = std::make_unique<BoundedQueue<LogRecord>>(queueCapacity, [this](LogRecord& record) { record.slabs = recordSlabs.get(); });
+        writer = context.writer;
+        if (writer == nullptr) {
+            ownWriter = std::make_unique<WriterThread>();
+            writer = ownWriter.get();
+        }
+        writer->attach(*this);
+    }
+    else if (mode == LoggingMode::FlightRecorder) {
+        flightRecorder = std::make_unique<FlightRecorder>(ringCapacity, ringSlotBytes);
+        if (ringCrashDump) {
+            flightRecorder->enableCrashDump(fs::path(logDirectory) / "crash-dump.log");
+            FlightRecorder::installCrashHandler();
+        }
+    }
+    if (configReloadMs > 0) {
+        configWatcher = std::make_unique<ConfigWatcher>(configPath, std::chrono::milliseconds(configReloadMs),
+            [this] { reloadConfig(); });
+    }
 }
 
 /**
- * @brief Logs a message to the current log file.
- * The function determines the correct log file based on the current time
- * and logging type. If a new log file is needed, it rotates logs accordingly.
+ * @brief Destructor. In asynchronous mode, drains every queued message to disk
+ * before stopping the writer thread.
+ */
+CircularLogger::~CircularLogger() {
+    configWatcher.reset();
+    reportSuppressed();
+    if (writer != nullptr) {
+        writer->detach(*this);
+        ownWriter.reset();
+    }
+    networkSink.reset();
+    std::lock_guard<std::mutex> lock(fileMutex);
+    flushStream();
+    saveIndex();
+    saveManifest(true);
+}
+
+/**
+ * @brief Logs a message at info level.
  * @param message The message to log.
  */
-void CircularLogger::log(const std::string& message) {
-    auto now = std::chrono::system_clock::now();
+void CircularLogger::log(std::string_view message) {
+    log(LogLevel::Info, message);
+}
+
+/**
+ * @brief Logs a message to the current log file if level passes the runtime threshold.
+ * In asynchronous mode the message is only copied into the queue and written
+ * later by the writer thread; in flight recorder mode it is only kept in
+ * memory until dumpFlightRecorder() is called or a message at ringDumpLevel
+ * arrives; otherwise it is written immediately.
+ * @param level The severity of the message.
+ * @param message The message to log.
+ */
+void CircularLogger::log(LogLevel level, std::string_view message) {
+    if (!shouldLog(level)) {
+        return;
+    }
+    messagesLogged.increment();
+    auto now = clock.now();
+    switch (mode) {
+    case LoggingMode::Async:
+        enqueue(now, level, message);
+        break;
+    case LoggingMode::FlightRecorder:
+        recordInRing(now, level, message);
+        break;
+    default:
+        writeRecord(now, level, currentThreadNumber(), message);
+        break;
+    }
+}
+
+/**
+ * @brief Logs a structured message at info level.
+ * @param message The message to log.
+ * @param fields Key/value pairs written with the message.
+ */
+void CircularLogger::log(std::string_view message, std::initializer_list<LogField> fields) {
+    log(LogLevel::Info, message, fields);
+}
+
+/**
+ * @brief Logs a message with key/value fields if level passes the runtime threshold.
+ * The fields are rendered on the calling thread straight into a reusable
+ * buffer: as JSON members in "json" files and as key=value pairs after the
+ * message otherwise. The flight recorder keeps them as key=value text, so a
+ * ring dumped to a JSON file carries them inside the message.
+ * @param level The severity of the message.
+ * @param message The message to log.
+ * @param fields Key/value pairs; their keys and strings are only read during the call.
+ */
+void CircularLogger::log(LogLevel level, std::string_view message, std::initializer_list<LogField> fields) {
+    if (!shouldLog(level)) {
+        return;
+    }
+    messagesLogged.increment();
+    auto now = clock.now();
+    switch (mode) {
+    case LoggingMode::Async: {
+        std::string_view rendered = renderFields(fields);
+        enqueueWith([&](LogRecord& record) { record.assign(now, level, message, rendered); });
+        break;
+    }
+    case LoggingMode::FlightRecorder:
+        staging.message.assign(message);
+        JsonLineWriter::appendKeyValues(staging.message, fields);
+        recordInRing(now, level, staging.message);
+        break;
+    default:
+        writeRecord(now, level, currentThreadNumber(), message, renderFields(fields));
+        break;
+    }
+}
+
+/**
+ * @brief Renders fields in the form the log file expects into the calling
+ * thread's field buffer.
+ * @param fields The fields to render.
+ * @return The rendered fields, valid until the next call on this thread.
+ */
+std::string_view CircularLogger::renderFields(std::initializer_list<LogField> fields) {
+    staging.fields.clear();
+    if (logFormat == LogFormat::Json) {
+        JsonLineWriter::appendFields(staging.fields, fields);
+    }
+    else {
+        JsonLineWriter::appendKeyValues(staging.fields, fields);
+    }
+    return staging.fields;
+}
+
+/**
+ * @brief Changes the runtime threshold; messages below level are discarded.
+ * Takes effect immediately on every thread.
+ * @param level The lowest level that is logged, or LogLevel::Off.
+ */
+void CircularLogger::setLevel(LogLevel level) {
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    LoggerSettings next = settings();
+    next.minimumLevel = level;
+    publishSettings(next);
+}
+
+/**
+ * @brief Formats a message straight into its destination: the staging line in
+ * synchronous mode or the queue slot in asynchronous mode.
+ * Backs the log(format, args...) template; the format string was already
+ * checked at compile time.
+ * @param level The severity of the message.
+ * @param format The format string.
+ * @param args The type-erased format arguments.
+ */
+void CircularLogger::logFormatted(LogLevel level, std::string_view format, std::format_args args) {
+    messagesLogged.increment();
+    auto now = clock.now();
+    switch (mode) {
+    case LoggingMode::Async:
+        enqueueWith([&](LogRecord& record) { record.assignFormatted(now, level, format, args); });
+        break;
+    case LoggingMode::FlightRecorder:
+        staging.message.clear();
+        std::vformat_to(std::back_inserter(staging.message), format, args);
+        recordInRing(now, level, staging.message);
+        break;
+    default: {
+        // Binary records need the length up front and JSON needs escaping, so only text formats in place
+        if (logFormat != LogFormat::Text) {
+            staging.message.clear();
+            std::vformat_to(std::back_inserter(staging.message), format, args);
+            writeRecord(now, level, currentThreadNumber(), staging.message);
+            break;
+        }
+        std::string& line = beginLine(now, level);
+        std::vformat_to(std::back_inserter(line), format, args);
+        commitLine(now, level);
+        break;
+    }
+    }
+}
+
+/**
+ * @brief Handles a message whose arguments were captured in binary form.
+ * In asynchronous mode the record is enqueued for the writer thread; in
+ * synchronous binary mode it is written as is.
+ * @param level The severity of the message.
+ * @param format The format string, with static storage duration.
+ * @param formatter Turns the encoded arguments into text on the writer thread.
+ * @param encodedArguments Arguments encoded by ArgumentCodec.
+ */
+void CircularLogger::logEncoded(LogLevel level, std::string_view format, ArgumentCodec::Formatter formatter,
+    std::string_view encodedArguments) {
+    messagesLogged.increment();
+    auto now = clock.now();
+    if (mode == LoggingMode::Async) {
+        enqueueWith([&](LogRecord& record) { record.assignEncoded(now, level, format, formatter, encodedArguments); });
+        return;
+    }
+    writeBinaryRecord(now, level, currentThreadNumber(), format, encodedArguments);
+}
+
+/**
+ * @brief Stores a message in the flight recorder and dumps the ring if the
+ * message is severe enough to warrant it.
+ * @param now The time the message was logged.
+ * @param level The severity of the message.
+ * @param message The message to store.
+ */
+void CircularLogger::recordInRing(std::chrono::system_clock::time_point now, LogLevel level, std::string_view message) {
+    flightRecorder->record(now, level, message);
+    if (level >= settings().ringDumpLevel) {
+        dumpFlightRecorder();
+    }
+}
+
+/**
+ * @brief Writes a deferred record on the writer thread: formatted as text or
+ * as an escaped JSON message, or with its encoded arguments untouched in binary files.
+ * @param record The dequeued record.
+ */
+void CircularLogger::writeDeferred(const LogRecord& record) {
+    if (logFormat == LogFormat::Binary) {
+        writeBinaryRecord(record.time, record.level, record.threadId, record.format, record.message());
+        return;
+    }
+    if (logFormat == LogFormat::Json) {
+        staging.message.clear();
+        try {
+            record.formatter(staging.message, record.format, reinterpret_cast<const std::byte*>(record.message().data()));
+        }
+        catch (const std::exception& e) {
+            staging.message += "<format error: ";
+            staging.message += e.what();
+            staging.message += ">";
+        }
+        writeRecord(record.time, record.level, record.threadId, staging.message);
+        return;
+    }
+    std::string& line = beginLine(record.time, record.level);
+    try {
+        record.formatter(line, record.format, reinterpret_cast<const std::byte*>(record.message().data()));
+    }
+    catch (const std::exception& e) {
+        line += "<format error: ";
+        line += e.what();
+        line += ">";
+    }
+    commitLine(record.time, record.level);
+}
+
+/**
+ * @brief Writes the messages retained by the flight recorder to the log file, oldest first.
+ * Messages written by an earlier dump are not repeated.
+ * Runs on the calling thread. Does nothing unless the logger is in flight recorder mode.
+ */
+void CircularLogger::dumpFlightRecorder() {
+    if (!flightRecorder) {
+        return;
+    }
+    std::lock_guard<std::mutex> dumpLock(ringDumpMutex);
+    ringDumpedUpTo = flightRecorder->forEach(ringDumpedUpTo,
+        [this](std::chrono::system_clock::time_point time, LogLevel level, std::string_view message) {
+            writeRecord(time, level, 0, message);
+        });
+    std::lock_guard<std::mutex> lock(fileMutex);
+    flushStream();
+}
+
+/**
+ * @brief Writes a message to the current log file.
+ * The function determines the correct log file based on the message time
+ * and logging type. If a new log file is needed, it rotates logs accordingly.
+ * Safe to call from several threads at once: the line is formatted on the
+ * calling thread and only the final append is serialized. Outside of
+ * rotation this path does not allocate once the staging buffer has grown.
+ * @param now The time the message was logged.
+ * @param level The severity of the message.
+ * @param threadId Number of the thread that logged the message.
+ * @param message The message to write.
+ * @param fields Fields rendered by renderFields(), or empty.
+ */
+void CircularLogger::writeRecord(std::chrono::system_clock::time_point now, LogLevel level, std::uint32_t threadId,
+    std::string_view message, std::string_view fields) {
+    if (logFormat == LogFormat::Binary) {
+        writeBinaryRecord(now, level, threadId, std::string_view(), message, fields);
+        return;
+    }
+    if (logFormat == LogFormat::Json) {
+        std::string& line = staging.line;
+        line.clear();
+        JsonLineWriter::appendRecordStart(line, staging.timestamps.format(now, settings().timestampPrecision),
+            logLevelName(level), threadId);
+        JsonLineWriter::appendEscaped(line, message);
+        line += '"';
+        line += fields;
+        line += '}';
+        commitLine(now, level);
+        return;
+    }
+    std::string& line = beginLine(now, level);
+    line += message;
+    line += fields;
+    commitLine(now, level);
+}
+
+/**
+ * @brief Stages a binary message record and writes it.
+ * @param now The time the message was logged.
+ * @param level The severity of the message.
+ * @param threadId Number of the thread that logged the message.
+ * @param format Format string of encoded arguments, or empty for plain text.
+ * @param payload The message text or the encoded arguments.
+ * @param fields Key=value fields that follow a plain text payload, or empty.
+ */
+void CircularLogger::writeBinaryRecord(std::chrono::system_clock::time_point now, LogLevel level, std::uint32_t threadId,
+    std::string_view format, std::string_view payload, std::string_view fields) {
+    std::string& record = staging.line;
+    record.clear();
+    std::int64_t timeMicros = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+    BinaryLogFormat::appendMessageHeader(record, static_cast<std::uint8_t>(level), threadId, timeMicros, 0,
+        payload.size() + fields.size());
+    record.append(payload);
+    record.append(fields);
+    commitStaged(now, level, format);
+}
+
+/**
+ * @brief Starts a line in the calling thread's staging buffer with the timestamp and level prefix.
+ * The caller appends the message and then calls commitLine().
+ * @param now The time the message was logged.
+ * @param level The severity of the message.
+ * @return The staging buffer.
+ */
+std::string& CircularLogger::beginLine(std::chrono::system_clock::time_point now, LogLevel level) {
+    staging.line.assign(staging.timestamps.format(now, settings().timestampPrecision));
+    staging.line += ' ';
+    staging.line += logLevelName(level);
+    staging.line += " - ";
+    return staging.line;
+}
+
+/**
+ * @brief Terminates the staged line and commits it.
+ * @param now The time the message was logged.
+ * @param level The severity of the message.
+ */
+void CircularLogger::commitLine(std::chrono::system_clock::time_point now, LogLevel level) {
+    staging.line += '\n';
+    commitStaged(now, level, std::string_view());
+}
+
+/**
+ * @brief Appends the staged record to the current log file, rotating first if needed,
+ * and hands it to the network sink, if there is one. Both happen under fileMutex,
+ * so the collector receives lines in the order of the files.
+ * @param now The time the message was logged.
+ * @param level The severity of the message.
+ * @param binaryFormat For binary records with encoded arguments, their format string.
+ */
+void CircularLogger::commitStaged(std::chrono::system_clock::time_point now, LogLevel level, std::string_view binaryFormat) {
+    std::string& line = staging.line;
     std::time_t nowTime = std::chrono::system_clock::to_time_t(now);
-    std::tm timeInfo;
-    localtime_s(&timeInfo, &nowTime);
 
-    // Generate the appropriate log file name
-    std::string logFileName = generateLogFileName(timeInfo);
-    fs::path logFilePath = fs::path(logDirectory) / logFileName;
+    //check if we need to rotate files; only the thread that sees the deadline pass takes the lock
+    if (nowTime >= nextRotationTime.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        if (nowTime >= nextRotationTime.load(std::memory_order_relaxed)) {
+            startNextLogFile(localTimeOf(now), nowTime, false);
+            nextRotationTime.store(calculateNextRotationTime(nowTime), std::memory_order_release);
+            saveManifest(false);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    // Size-based rotation keeps each file below the limit unless a single line is larger
+    std::uint64_t maxFileBytes = fileSizeLimit();
+    if (maxFileBytes > 0 && currentFileBytes > 0 && currentFileBytes + line.size() > maxFileBytes) {
+        startNextLogFile(localTimeOf(now), nowTime, true);
+        saveManifest(false);
+    }
+    if (logFormat == LogFormat::Binary) {
+        prepareBinaryRecord(binaryFormat);
+    }
+    if (indexing) {
+        logIndex.add(currentFileBytes, printedMicros(now, settings().timestampPrecision), line);
+    }
+    appendLine(line);
+    if (networkSink) {
+        networkSink->submit(level, line);
+    }
+}
+
+/**
+ * @brief Returns the local time for now from the calling thread's timestamp cache.
+ * @param now The time to convert.
+ * @return The broken-down local time, valid until the cache is next used.
+ */
+const std::tm& CircularLogger::localTimeOf(std::chrono::system_clock::time_point now) {
+    staging.timestamps.format(now, TimestampPrecision::Seconds);
+    return staging.timestamps.localTime();
+}
+
+/**
+ * @brief Writes what a binary record needs before it in the current file: the
+ * file magic for a new file and the definition of its format string the first
+ * time it is used in this file. Patches the format id into the staged record.
+ * Must be called with fileMutex held.
+ * @param format The record's format string, or empty for plain text.
+ */
+void CircularLogger::prepareBinaryRecord(std::string_view format) {
+    if (currentFileBytes == 0) {
+        appendLine(std::string_view(BinaryLogFormat::magic, sizeof(BinaryLogFormat::magic)));
+    }
+    if (format.empty()) {
+        return;
+    }
+    auto [entry, inserted] = formatIds.try_emplace(format.data(), nextFormatId);
+    if (inserted) {
+        ++nextFormatId;
+        staging.definition.clear();
+        BinaryLogFormat::appendFormatDefinition(staging.definition, entry->second, format);
+        appendLine(staging.definition);
+    }
+    std::memcpy(staging.line.data() + BinaryLogFormat::formatIdOffset, &entry->second, sizeof(entry->second));
+}
+
+/**
+ * @brief Picks the name of the next log file, rotates and opens it.
+ * A time-based rotation into a period that already has a file resumes its
+ * latest part; a size-based rotation within the same period starts the next
+ * numbered part ("2024-01-31-12.1.log", "2024-01-31-12.2.log", ...).
+ * Must be called with fileMutex held.
+ * @param timeInfo The local time used for the file name.
+ * @param nowTime The current time.
+ * @param sizeLimitReached true if the current file reached maxFileBytes.
+ */
+void CircularLogger::startNextLogFile(const std::tm& timeInfo, std::time_t nowTime, bool sizeLimitReached) {
+    std::string periodName = generateLogFileName(timeInfo, 0);
+    if (periodName != currentPeriodName) {
+        currentPeriodName = periodName;
+        currentSequence = 0;
+    }
+    else if (sizeLimitReached) {
+        ++currentSequence;
+    }
+
+    RetainedLogFile nextFile{ fs::path(logDirectory) / generateLogFileName(timeInfo, currentSequence), nowTime, currentSequence, 0 };
+    auto rotationStart = std::chrono::steady_clock::now();
+    rotateLogs(nextFile);
+    rotationLatency.record(std::chrono::steady_clock::now() - rotationStart);
+    currentLogFile = nextFile.path;
+    if (segmentBytes > 0) {
+        LogFileWriter::preallocate(currentLogFile, segmentBytes);
+    }
+    openLogFile();
+    // Binary files are self-contained, so format ids start over in every file
+    formatIds.clear();
+    nextFormatId = 1;
+}
+
+/**
+ * @brief The size at which a file is rotated: maxFileBytes, capped to
+ * segmentBytes with a segment pool so that every file fits its reservation.
+ * @return The limit in bytes, 0 for none.
+ */
+std::uint64_t CircularLogger::fileSizeLimit() const {
+    std::uint64_t limit = settings().maxFileBytes;
+    if (segmentBytes > 0 && (limit == 0 || limit > segmentBytes)) {
+        limit = segmentBytes;
+    }
+    return limit;
+}
+
+/**
+ * @brief Appends a fully formatted line to the current log file.
+ * Must be called with fileMutex held.
+ * @param line The line to append, including its trailing newline.
+ */
+void CircularLogger::appendLine(std::string_view line) {
+    // Timing every append would cost more than most appends take, so only a sample is timed
+    bool timed = ++appendsSinceTimed == writeSampleInterval;
+    auto writeStart = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    bool written = keepFileOpen ? fileWriter->write(line) : LogFileWriter::appendToFile(currentLogFile, line);
+    if (timed) {
+        writeLatency.record(std::chrono::steady_clock::now() - writeStart);
+        appendsSinceTimed = 0;
+    }
+    if (!written) {
+        // Lost lines must not count towards the size limit, the manifest or the flush threshold
+        writeErrors.add(1);
+        return;
+    }
+    currentFileBytes += line.size();
+    bytesWritten.add(line.size());
+    if (!keepFileOpen) {
+        return;
+    }
+    // A batching backend may only now have failed to write earlier lines
+    discountLostBytes();
+    unflushedBytes += line.size();
+    if (!deferFlushes) {
+        flushIfNeeded();
+    }
+}
+
+/**
+ * @brief Makes sure every message logged so far has reached the log file.
+ * In asynchronous mode, blocks until the writer thread has drained the queue
+ * up to this point and flushed the file.
+ */
+void CircularLogger::flush() {
+    reportSuppressed();
+    if (mode != LoggingMode::Async) {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        flushStream();
+        return;
+    }
+    writer->flush(*this, acceptedCount.load());
+}
+
+/**
+ * @brief Remembers a call site whose rate limit started a suppressed run in
+ * this logger, so the run is reported even if the site never logs again.
+ * Only called for the first message of a run.
+ * @param site The call site.
+ */
+void CircularLogger::rememberSuppressedSite(LogCallSite& site) {
+    std::lock_guard<std::mutex> lock(suppressedSitesMutex);
+    if (std::find(suppressedSites.begin(), suppressedSites.end(), &site) == suppressedSites.end()) {
+        suppressedSites.push_back(&site);
+    }
+}
+
+/**
+ * @brief Logs the suppressed runs of the remembered call sites that no admitted
+ * message has reported yet, e.g. the end of a burst that simply stopped.
+ */
+void CircularLogger::reportSuppressed() {
+    std::vector<LogCallSite*> sites;
+    {
+        std::lock_guard<std::mutex> lock(suppressedSitesMutex);
+        sites.swap(suppressedSites);
+    }
+    for (LogCallSite* site : sites) {
+        if (std::uint64_t repeated = site->takeSuppressed(this)) {
+            log(site->suppressedLevel(), "message at {}:{} repeated {} times, suppressed by the rate limit",
+                site->file, site->line, repeated);
+        }
+    }
+}
+
+/**
+ * @brief Returns the number of messages discarded because the queue was full.
+ */
+std::uint64_t CircularLogger::droppedMessages() const {
+    return droppedCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the number of retired files still waiting for housekeeping.
+ */
+std::size_t CircularLogger::housekeepingQueueDepth() const {
+    return housekeeper->queueDepth();
+}
+
+/**
+ * @brief Returns a snapshot of the logger's counters and latency histograms.
+ * Reading never blocks logging threads: per-thread counts are summed and the
+ * other values are read with relaxed loads, so the fields may be a few
+ * messages apart from each other while logging continues.
+ */
+LoggerStats CircularLogger::stats() const {
+    LoggerStats snapshot;
+    snapshot.messagesLogged = messagesLogged.total();
+    snapshot.messagesDropped = droppedCount.load(std::memory_order_relaxed);
+    snapshot.messagesSuppressed = messagesSuppressed.total();
+    snapshot.bytesWritten = bytesWritten.load();
+    snapshot.writeErrors = writeErrors.load();
+    snapshot.queueHighWater = static_cast<std::size_t>(queueHighWater.load());
+    if (networkSink) {
+        snapshot.networkSent = networkSink->sentCount();
+        snapshot.networkDropped = networkSink->droppedCount();
+    }
+    snapshot.writeLatency = writeLatency.snapshot();
+    snapshot.flushLatency = flushLatency.snapshot();
+    snapshot.rotationLatency = rotationLatency.snapshot();
+    snapshot.flushes = snapshot.flushLatency.count;
+    snapshot.rotations = snapshot.rotationLatency.count;
+    return snapshot;
+}
+
+/**
+ * @brief Flushes any buffered output of the persistent log file to disk.
+ * Must be called with fileMutex held.
+ */
+void CircularLogger::flushStream() {
+    if (fileWriter->isOpen()) {
+        auto flushStart = std::chrono::steady_clock::now();
+        fileWriter->flush();
+        flushLatency.record(std::chrono::steady_clock::now() - flushStart);
+        discountLostBytes();
+    }
+    unflushedBytes = 0;
+    lastFlushTime = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief Takes bytes that the output backend accepted earlier but then failed
+ * to write, e.g. in a failed batch, back out of the file size and bytesWritten
+ * and counts the failure. Must be called with fileMutex held.
+ */
+void CircularLogger::discountLostBytes() {
+    std::uint64_t lost = fileWriter->takeLostBytes();
+    if (lost == 0) {
+        return;
+    }
+    writeErrors.add(1);
+    currentFileBytes -= std::min(lost, currentFileBytes);
+    bytesWritten.subtract(lost);
+}
+
+/**
+ * @brief Opens the current log file for appending and keeps it open until the next rotation.
+ * Does nothing when the logger is configured to reopen the file for every message.
+ * Must be called with fileMutex held.
+ */
+void CircularLogger::openLogFile() {
+    if (!keepFileOpen) {
+        return;
+    }
+    if (!fileWriter->open(currentLogFile)) {
+        std::cerr << "Error opening log file: " << currentLogFile << std::endl;
+    }
+    unflushedBytes = 0;
+    lastFlushTime = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief Flushes the persistent log file if the configured flush policy requires it.
+ * The interval policy is evaluated on each call, so an idle logger keeps its
+ * buffered tail until the next message, flush() or destruction.
+ * Must be called with fileMutex held.
+ */
+void CircularLogger::flushIfNeeded() {
+    const LoggerSettings& current = settings();
+    switch (current.flushPolicy) {
+    case FlushPolicy::EveryLine:
+        flushStream();
+        break;
+    case FlushPolicy::Bytes:
+        if (unflushedBytes >= current.flushBytes) {
+            flushStream();
+        }
+        break;
+    case FlushPolicy::Interval:
+        if (std::chrono::steady_clock::now() - lastFlushTime >= std::chrono::milliseconds(current.flushIntervalMs)) {
+            flushStream();
+        }
+        break;
+    }
+}
+
+/**
+ * @brief Copies a message into the queue, applying the overflow policy if it is full.
+ * @param now The time the message was logged.
+ * @param level The severity of the message.
+ * @param message The message to enqueue.
+ */
+void CircularLogger::enqueue(std::chrono::system_clock::time_point now, LogLevel level, std::string_view message) {
+    enqueueWith([&](LogRecord& record) { record.assign(now, level, message); });
+}
+
+/**
+ * @brief Claims a queue slot and lets fill(LogRecord&) write the record into it,
+ * applying the overflow policy if the queue is full.
+ * @param fill Callable that fills the claimed record.
+ */
+template <typename Fill>
+void CircularLogger::enqueueWith(Fill&& fill) {
+    while (!queue->tryPush(fill)) {
+        OverflowPolicy overflowPolicy = settings().overflowPolicy;
+        if (overflowPolicy == OverflowPolicy::DropNewest) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (overflowPolicy == OverflowPolicy::DropOldest) {
+            if (queue->tryPop([](LogRecord& record) { record.releaseSlab(); })) {
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                processedCount.fetch_add(1);
+            }
+            continue;
+        }
+        writer->wake();
+        std::this_thread::yield();
+    }
+    acceptedCount.fetch_add(1);
+    writer->wake();
+}
 
-    //check if we need to rotate files
-    if (nowTime >= nextRotationTime) {
-        // Generate the appropriate log file name
-        std::string logFileName = generateLogFileName(timeInfo);
-        fs::path logFilePath = fs::path(logDirectory) / logFileName;
-        rotateLogs();
-        currentLogFile = logFilePath;
-        nextRotationTime = calculateNextRotationTime(nowTime);
+/**
+ * @brief Flushes the file and marks every message processed so far as
+ * flushed, waking flush() callers. Runs on the writer thread with the
+ * writer's mutex held.
+ */
+void CircularLogger::completeFlush() {
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    flushStream();
+    flushedCount = processedCount.load();
+}
+
+/**
+ * @brief Completes a pending flush() as soon as the messages it waits for
+ * are written, even if newer ones keep arriving, so a flush never waits for
+ * the queue to run empty. Runs on the writer thread with the writer's mutex held.
+ * @return true if a flush was completed.
+ */
+bool CircularLogger::serviceFlush() {
+    if (flushTarget <= flushedCount || processedCount.load() < flushTarget) {
+        return false;
     }
+    completeFlush();
+    return true;
+}
+
+/**
+ * @brief How long the writer thread may sleep without missing this logger's
+ * interval flush.
+ */
+std::chrono::milliseconds CircularLogger::idleTimeout() const {
+    const LoggerSettings& current = settings();
+    return std::chrono::milliseconds(current.flushPolicy == FlushPolicy::Interval ? current.flushIntervalMs : 100);
+}
+
+/**
+ * @brief Applies the interval flush policy while the logger is idle. Runs on
+ * the writer thread after each wait.
+ */
+void CircularLogger::flushOnInterval() {
+    if (settings().flushPolicy == FlushPolicy::Interval) {
+        std::lock_guard<std::mutex> fileLock(fileMutex);
+        flushIfNeeded();
+    }
+}
 
-    std::ofstream logFile(currentLogFile, std::ios::app);
-    logFile << std::put_time(&timeInfo, "%Y-%m-%d %H:%M:%S") << " - " << message << "\n";
+/**
+ * @brief Writes up to one queue's worth of records to disk.
+ * @return The number of records written.
+ */
+std::size_t CircularLogger::drainQueue() {
+    std::size_t drained = 0;
+    std::size_t batchLimit = queue->capacity();
+    auto write = [this](LogRecord& record) {
+        if (record.formatter != nullptr) {
+            writeDeferred(record);
+        }
+        else {
+            writeRecord(record.time, record.level, record.threadId, record.message(), record.fields());
+        }
+        record.releaseSlab();
+    };
+    queueHighWater.raiseTo(queue->size());
+    // The flush policy is applied once per batch rather than once per record
+    deferFlushes = true;
+    while (drained < batchLimit && queue->tryPop(write)) {
+        ++drained;
+    }
+    deferFlushes = false;
+    if (drained > 0) {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        flushIfNeeded();
+    }
+    processedCount.fetch_add(drained);
+    return drained;
 }
 
 /**
@@ -49,24 +866,334 @@ void CircularLogger::log(const std::string& message) {
  * If the file does not exist or contains invalid data, default values are used.
  */
 void CircularLogger::loadConfig() {
+    LoggerSettings loaded;
     std::ifstream configFile(configPath);
     if (!configFile.is_open()) {
         saveDefaultConfig(); // Create config file with default values if missing
-        return;
+    }
+    else {
+        json configJson;
+        // Load values or use defaults if missing
+        try {
+            configFile >> configJson;
+            loaded = parseSettings(configJson);
+            logDirectory = configJson.value("logDirectory", logDirectory);
+            clock = LogClock(parseClockSource(configJson.value("clock", "system")));
+            keepFileOpen = configJson.value("keepFileOpen", true);
+            mode = parseLoggingMode(configJson.value("mode", "sync"));
+            queueCapacity = configJson.value("queueCapacity", 8192);
+            recordSlabCount = configJson.value("recordSlabCount", recordSlabCount);
+            recordSlabBytes = configJson.value("recordSlabBytes", recordSlabBytes);
+            ringCapacity = configJson.value("ringCapacity", ringCapacity);
+            ringSlotBytes = configJson.value("ringSlotBytes", ringSlotBytes);
+            ringCrashDump = configJson.value("ringCrashDump", true);
+            logFormat = parseLogFormat(configJson.value("format", "text"));
+            // Deferred formatting needs a writer thread to do the formatting; binary
+            // files store the captured arguments as they are, except in flight recorder mode
+            deferredFormatting = (configJson.value("deferredFormatting", false) && mode == LoggingMode::Async)
+                || (logFormat == LogFormat::Binary && mode != LoggingMode::FlightRecorder);
+            writerOptions.mode = parseOutputMode(configJson.value("outputMode", "stream"));
+            writerOptions.mappedSegmentBytes = configJson.value("mappedSegmentBytes", writerOptions.mappedSegmentBytes);
+            writerOptions.maxBatchRecords = configJson.value("maxBatchRecords", writerOptions.maxBatchRecords);
+            writerOptions.maxBatchLatencyMs = configJson.value("maxBatchLatencyMs", writerOptions.maxBatchLatencyMs);
+            writerOptions.directBufferBytes = configJson.value("directBufferBytes", writerOptions.directBufferBytes);
+            if (writerOptions.mode != OutputMode::Stream) {
+                keepFileOpen = true; // only the stream writer can reopen per message
+            }
+            compressRetiredFiles = configJson.value("compression", "none") == "zstd";
+            compressionLevel = configJson.value("compressionLevel", 3);
+            if (compressRetiredFiles && !Housekeeper::compressionAvailable()) {
+                std::cerr << "compression \"zstd\" requested but this build has no zstd, keeping files uncompressed" << std::endl;
+                compressRetiredFiles = false;
+            }
+            segmentBytes = configJson.value("segmentBytes", std::uint64_t{ 0 });
+            if (segmentBytes > 0 && compressRetiredFiles) {
+                std::cerr << "segmentBytes is ignored with compression, retired files are replaced by their .zst" << std::endl;
+                segmentBytes = 0;
+            }
+            configReloadMs = configJson.value("configReloadMs", 1000);
+            networkOptions.protocol = parseNetworkProtocol(configJson.value("networkProtocol", "none"));
+            networkOptions.host = configJson.value("networkHost", networkOptions.host);
+            networkOptions.port = configJson.value("networkPort", networkOptions.port);
+            networkOptions.bufferBytes = configJson.value("networkBufferBytes", networkOptions.bufferBytes);
+            networkOptions.spillBytes = configJson.value("networkSpillBytes", networkOptions.spillBytes);
+            networkOptions.maxBackoffMs = configJson.value("networkMaxBackoffMs", networkOptions.maxBackoffMs);
+            indexCheckpointBytes = configJson.value("indexCheckpointBytes", indexCheckpointBytes);
+            indexBloomBytes = configJson.value("indexBloomBytes", indexBloomBytes);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error loading configuration: " << e.what() << std::endl;
+        }
     }
 
-    json configJson;
-    // Load values or use defaults if missing
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    publishSettings(loaded);
+}
+
+/**
+ * @brief Re-reads the configuration file and publishes the settings that can
+ * change at runtime. Runs on the config watcher thread; log() keeps using the
+ * previous snapshot until the new one is published and never waits for it.
+ * Settings that shape the logger itself (mode, format, output mode, queue and
+ * ring sizes) only take effect on the next start. If the file cannot be
+ * parsed, for instance because it is caught half-written, the current
+ * settings stay in effect.
+ */
+void CircularLogger::reloadConfig() {
+    std::ifstream configFile(configPath);
+    if (!configFile.is_open()) {
+        return;
+    }
+    LoggerSettings next;
     try {
+        json configJson;
         configFile >> configJson;
-        loggingType = configJson.value("loggingType", "second");
-        frequency = configJson.value("frequency", 5);
-        maxEntries = configJson.value("maxEntries", 12);
+        next = parseSettings(configJson);
     }
     catch (const std::exception& e) {
-        std::cerr << "Error loading configuration: " << e.what() << std::endl;
+        std::cerr << "Error reloading configuration: " << e.what() << std::endl;
+        return;
+    }
+
+    bool rotationChanged;
+    {
+        std::lock_guard<std::mutex> lock(settingsMutex);
+        const LoggerSettings& current = settings();
+        rotationChanged = next.rotationUnit != current.rotationUnit || next.frequency != current.frequency;
+        publishSettings(next);
+    }
+    if (rotationChanged) {
+        // The next message starts a file named and timed by the new rotation settings
+        std::lock_guard<std::mutex> lock(fileMutex);
+        nextRotationTime.store(0, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Reads the runtime-changeable settings from a parsed configuration.
+ * @param configJson The parsed configuration file.
+ * @return The settings, with defaults for missing keys.
+ */
+LoggerSettings CircularLogger::parseSettings(const json& configJson) {
+    LoggerSettings parsed;
+    parsed.rotationUnit = parseRotationUnit(configJson.value("loggingType", "second"));
+    parsed.frequency = configJson.value("frequency", 5);
+    parsed.maxEntries = configJson.value("maxEntries", 12);
+    parsed.flushPolicy = parseFlushPolicy(configJson.value("flushPolicy", "line"));
+    parsed.flushBytes = configJson.value("flushBytes", 4096);
+    parsed.flushIntervalMs = configJson.value("flushIntervalMs", 1000);
+    parsed.overflowPolicy = parseOverflowPolicy(configJson.value("overflowPolicy", "block"));
+    parsed.ringDumpLevel = parseLogLevel(configJson.value("ringDumpLevel", "off"));
+    parsed.minimumLevel = parseLogLevel(configJson.value("level", "info"));
+    parsed.timestampPrecision = parseTimestampPrecision(configJson.value("timestampPrecision", "s"));
+    parsed.maxFileBytes = configJson.value("maxFileBytes", std::uint64_t{ 0 });
+    parsed.maxTotalBytes = configJson.value("maxTotalBytes", std::uint64_t{ 0 });
+    parsed.rateLimitPerSecond = configJson.value("rateLimitPerSecond", 0.0);
+    parsed.rateLimitBurst = std::max(1, configJson.value("rateLimitBurst", 10));
+    return parsed;
+}
+
+/**
+ * @brief Makes next the settings every thread sees from now on.
+ * Earlier snapshots are kept until the logger is destroyed, so a thread that
+ * loaded one just before the switch can keep using it; reloads are rare, so
+ * the retained snapshots stay small. Must be called with settingsMutex held.
+ * @param next The new settings.
+ */
+void CircularLogger::publishSettings(const LoggerSettings& next) {
+    publishedSettings.push_back(std::make_unique<const LoggerSettings>(next));
+    activeSettings.store(publishedSettings.back().get(), std::memory_order_release);
+}
+
+/**
+ * @brief Converts the "loggingType" configuration value to a RotationUnit.
+ * Parsed once so rotation never compares strings. Unknown values fall back to seconds.
+ * @param name One of "day", "hour", "minute" or "second".
+ * @return The matching rotation unit.
+ */
+RotationUnit CircularLogger::parseRotationUnit(const std::string& name) {
+    if (name == "day") {
+        return RotationUnit::Day;
+    }
+    if (name == "hour") {
+        return RotationUnit::Hour;
+    }
+    if (name == "minute") {
+        return RotationUnit::Minute;
+    }
+    if (name != "second") {
+        std::cerr << "Unknown loggingType \"" << name << "\", using \"second\"" << std::endl;
+    }
+    return RotationUnit::Second;
+}
+
+/**
+ * @brief Converts the "mode" configuration value to a LoggingMode.
+ * Unknown values fall back to synchronous logging.
+ * @param name One of "sync", "async" or "ring".
+ * @return The matching logging mode.
+ */
+LoggingMode CircularLogger::parseLoggingMode(const std::string& name) {
+    if (name == "async") {
+        return LoggingMode::Async;
+    }
+    if (name == "ring") {
+        return LoggingMode::FlightRecorder;
+    }
+    return LoggingMode::Sync;
+}
+
+/**
+ * @brief Converts the "format" configuration value to a LogFormat.
+ * Unknown values fall back to text.
+ * @param name One of "text", "binary" or "json".
+ * @return The matching file format.
+ */
+LogFormat CircularLogger::parseLogFormat(const std::string& name) {
+    if (name == "binary") {
+        return LogFormat::Binary;
+    }
+    if (name == "json") {
+        return LogFormat::Json;
+    }
+    return LogFormat::Text;
+}
+
+/**
+ * @brief Converts a level name from the configuration to a LogLevel.
+ * Unknown values fall back to info.
+ * @param name One of "trace", "debug", "info", "warn", "error" or "off".
+ * @return The matching level.
+ */
+LogLevel CircularLogger::parseLogLevel(const std::string& name) {
+    if (name == "trace") {
+        return LogLevel::Trace;
+    }
+    if (name == "debug") {
+        return LogLevel::Debug;
+    }
+    if (name == "warn") {
+        return LogLevel::Warn;
+    }
+    if (name == "error") {
+        return LogLevel::Error;
+    }
+    if (name == "off") {
+        return LogLevel::Off;
+    }
+    if (name != "info") {
+        std::cerr << "Unknown level \"" << name << "\", using \"info\"" << std::endl;
+    }
+    return LogLevel::Info;
+}
+
+/**
+ * @brief Converts the "flushPolicy" configuration value to a FlushPolicy.
+ * Unknown values fall back to flushing every line.
+ * @param name One of "line", "bytes" or "interval".
+ * @return The matching flush policy.
+ */
+FlushPolicy CircularLogger::parseFlushPolicy(const std::string& name) {
+    if (name == "bytes") {
+        return FlushPolicy::Bytes;
+    }
+    if (name == "interval") {
+        return FlushPolicy::Interval;
+    }
+    return FlushPolicy::EveryLine;
+}
+
+/**
+ * @brief Converts the "overflowPolicy" configuration value to an OverflowPolicy.
+ * Unknown values fall back to blocking, which never loses messages.
+ * @param name One of "block", "drop-newest" or "drop-oldest".
+ * @return The matching overflow policy.
+ */
+OverflowPolicy CircularLogger::parseOverflowPolicy(const std::string& name) {
+    if (name == "drop-newest") {
+        return OverflowPolicy::DropNewest;
+    }
+    if (name == "drop-oldest") {
+        return OverflowPolicy::DropOldest;
+    }
+    return OverflowPolicy::Block;
+}
+
+/**
+ * @brief Converts the "timestampPrecision" configuration value to a TimestampPrecision.
+ * Unknown values fall back to whole seconds.
+ * @param name One of "s", "ms" or "us".
+ * @return The matching timestamp precision.
+ */
+TimestampPrecision CircularLogger::parseTimestampPrecision(const std::string& name) {
+    if (name == "ms") {
+        return TimestampPrecision::Milliseconds;
+    }
+    if (name == "us") {
+        return TimestampPrecision::Microseconds;
+    }
+    return TimestampPrecision::Seconds;
+}
+
+/**
+ * @brief Converts the "clock" configuration value to a ClockSource.
+ * Unknown values, and "tsc" on a CPU without an invariant TSC, fall back to the system clock.
+ * @param name One of "system", "coarse" or "tsc".
+ * @return The matching clock source.
+ */
+ClockSource CircularLogger::parseClockSource(const std::string& name) {
+    if (name == "coarse") {
+        return ClockSource::Coarse;
+    }
+    if (name == "tsc") {
+        if (LogClock::tscAvailable()) {
+            return ClockSource::Tsc;
+        }
+        std::cerr << "clock \"tsc\" requested but this CPU has no invariant TSC, using \"system\"" << std::endl;
+        return ClockSource::System;
+    }
+    if (name != "system") {
+        std::cerr << "Unknown clock \"" << name << "\", using \"system\"" << std::endl;
+    }
+    return ClockSource::System;
+}
+
+/**
+ * @brief Converts the "outputMode" configuration value to an OutputMode.
+ * Unknown values fall back to the stream writer.
+ * @param name One of "stream", "mmap", "vectored" or "direct".
+ * @return The matching output mode.
+ */
+OutputMode CircularLogger::parseOutputMode(const std::string& name) {
+    if (name == "mmap") {
+        return OutputMode::Mapped;
+    }
+    if (name == "vectored") {
+        return OutputMode::Vectored;
     }
+    if (name == "direct") {
+        return OutputMode::Direct;
+    }
+    return OutputMode::Stream;
+}
 
+/**
+ * @brief Converts the "networkProtocol" configuration value to a NetworkProtocol.
+ * Unknown values disable the network sink.
+ * @param name One of "none", "syslog", "tcp" or "framed".
+ * @return The matching protocol.
+ */
+NetworkProtocol CircularLogger::parseNetworkProtocol(const std::string& name) {
+    if (name == "syslog") {
+        return NetworkProtocol::Syslog;
+    }
+    if (name == "tcp") {
+        return NetworkProtocol::Tcp;
+    }
+    if (name == "framed") {
+        return NetworkProtocol::Framed;
+    }
+    return NetworkProtocol::None;
 }
 
 /**
@@ -76,7 +1203,47 @@ void CircularLogger::saveDefaultConfig() {
     json defaultConfig = {
         {"loggingType", "second"},
         {"frequency", 5},
-        {"maxEntries", 12}
+        {"maxEntries", 12},
+        {"keepFileOpen", true},
+        {"flushPolicy", "line"},
+        {"flushBytes", 4096},
+        {"flushIntervalMs", 1000},
+        {"mode", "sync"},
+        {"queueCapacity", 8192},
+        {"overflowPolicy", "block"},
+        {"ringCapacity", 4096},
+        {"ringSlotBytes", 256},
+        {"ringCrashDump", true},
+        {"deferredFormatting", false},
+        {"format", "text"},
+        {"level", "info"},
+        {"ringDumpLevel", "off"},
+        {"configReloadMs", 1000},
+        {"compression", "none"},
+        {"compressionLevel", 3},
+        {"timestampPrecision", "s"},
+        {"maxFileBytes", 0},
+        {"maxTotalBytes", 0},
+        {"segmentBytes", 0},
+        {"outputMode", "stream"},
+        {"mappedSegmentBytes", 64 * 1024 * 1024},
+        {"maxBatchRecords", 256},
+        {"maxBatchLatencyMs", 5},
+        {"directBufferBytes", 1024 * 1024},
+        {"logDirectory", logDirectory},
+        {"clock", "system"},
+        {"networkProtocol", "none"},
+        {"networkHost", "127.0.0.1"},
+        {"networkPort", 514},
+        {"networkBufferBytes", 1024 * 1024},
+        {"networkSpillBytes", 64 * 1024 * 1024},
+        {"networkMaxBackoffMs", 30000},
+        {"indexCheckpointBytes", 64 * 1024},
+        {"indexBloomBytes", 0},
+        {"recordSlabCount", 256},
+        {"recordSlabBytes", 4096},
+        {"rateLimitPerSecond", 0},
+        {"rateLimitBurst", 10}
     };
     std::ofstream configFile(configPath);
     configFile << defaultConfig.dump(4);
@@ -84,33 +1251,47 @@ void CircularLogger::saveDefaultConfig() {
 
 /**
  * @brief Ensures that the log directory exists.
- * If the directory does not exist, it is created.
+ * If the directory does not exist, it is created along with missing parents.
  */
 void CircularLogger::ensureLogDirectory() {
     if (!fs::exists(logDirectory)) {
-        fs::create_directory(logDirectory);
+        fs::create_directories(logDirectory);
     }
 }
 
 /**
  * @brief Generates a log file name based on the current time.
- * The file name format is determined by the logging type.
+ * The file name format is determined by the logging type. The name is
+ * assembled in a stack buffer, so only the returned string allocates.
  * @param timeInfo The current time information.
+ * @param sequence Part number within the period; 0 for the first file.
  * @return The generated log file name.
  */
-std::string CircularLogger::generateLogFileName(const std::tm& timeInfo) {
-    std::ostringstream oss;
-    oss << std::put_time(&timeInfo, "%Y-%m-%d");
-    if (loggingType == "hour") {
-        oss << "-" << std::put_time(&timeInfo, "%H");
-    }
-    else if (loggingType == "minute") {
-        oss << "-" << std::put_time(&timeInfo, "%H-%M");
+std::string CircularLogger::generateLogFileName(const std::tm& timeInfo, int sequence) {
+    const char* layout = "%Y-%m-%d";
+    switch (settings().rotationUnit) {
+    case RotationUnit::Hour:
+        layout = "%Y-%m-%d-%H";
+        break;
+    case RotationUnit::Minute:
+        layout = "%Y-%m-%d-%H-%M";
+        break;
+    case RotationUnit::Second:
+        layout = "%Y-%m-%d-%H-%M-%S";
+        break;
+    case RotationUnit::Day:
+        break;
     }
-    else if (loggingType == "second") {
-        oss << "-" << std::put_time(&timeInfo, "%H-%M-%S");
+    char name[64];
+    std::size_t length = std::strftime(name, sizeof(name), layout, &timeInfo);
+    char* end = name + length;
+    if (sequence > 0) {
+        *end++ = '.';
+        end = std::to_chars(end, name + sizeof(name), sequence).ptr;
     }
-    return oss.str() + ".log";
+    std::string fileName(name, end);
+    fileName += ".log";
+    return fileName;
 }
 
 /**
@@ -121,41 +1302,423 @@ std::string CircularLogger::generateLogFileName(const std::tm& timeInfo) {
  */
 std::time_t CircularLogger::calculateNextRotationTime(std::time_t currentTime) {
     std::tm nextTime;
-    localtime_s(&nextTime, &currentTime);
-    if (loggingType == "hour") {
+    TimestampCache::toLocalTime(currentTime, nextTime);
+    const LoggerSettings& current = settings();
+    int frequency = current.frequency;
+    switch (current.rotationUnit) {
+    case RotationUnit::Day:
+        nextTime.tm_mday += frequency;
+        nextTime.tm_hour = 0;
+        nextTime.tm_min = 0;
+        nextTime.tm_sec = 0;
+        break;
+    case RotationUnit::Hour:
         nextTime.tm_hour += frequency;
         nextTime.tm_min = 0;
         nextTime.tm_sec = 0;
-    }
-    else if (loggingType == "minute") {
+        break;
+    case RotationUnit::Minute:
         nextTime.tm_min += frequency;
         nextTime.tm_sec = 0;
-    }
-    else if (loggingType == "second") {
+        break;
+    case RotationUnit::Second:
         nextTime.tm_sec += frequency;
+        break;
     }
+    nextTime.tm_isdst = -1;
     return std::mktime(&nextTime);
 }
 
 /**
- * @brief Rotates log files based on the maximum number of entries.
- * If the number of log files exceeds the maximum, the oldest files are deleted.
+ * @brief Parses the start time and part number of a log file from a name produced by generateLogFileName.
+ * Accepts every rotation granularity ("YYYY-MM-DD" up to "YYYY-MM-DD-HH-MM-SS")
+ * so files written under a previous loggingType are still recognised, and
+ * compressed files ("<name>.log.zst").
+ * @param fileName The file name without directory.
+ * @param startTime Receives the parsed local time.
+ * @param sequence Receives the part number, 0 for the first file of a period.
+ * @return true if the name matches the log file naming scheme.
+ */
+bool CircularLogger::parseLogFileName(std::string_view fileName, std::time_t& startTime, int& sequence) {
+    static constexpr std::string_view extension = ".log";
+    if (fileName.ends_with(Housekeeper::compressedExtension)) {
+        fileName.remove_suffix(std::string_view(Housekeeper::compressedExtension).size());
+    }
+    if (fileName.size() <= extension.size() || !fileName.ends_with(extension)) {
+        return false;
+    }
+
+    auto parseNumber = [&fileName](std::size_t& pos, std::size_t end, int& value) {
+        std::size_t digitsStart = pos;
+        value = 0;
+        while (pos < end && fileName[pos] >= '0' && fileName[pos] <= '9') {
+            value = value * 10 + (fileName[pos] - '0');
+            ++pos;
+        }
+        return pos != digitsStart;
+    };
+
+    std::size_t end = fileName.size() - extension.size();
+    std::size_t stemEnd = std::min(fileName.find('.'), end);
+    sequence = 0;
+    if (stemEnd < end) {
+        std::size_t pos = stemEnd + 1;
+        if (!parseNumber(pos, end, sequence) || pos != end) {
+            return false;
+        }
+    }
+
+    int fields[6] = { 0, 1, 1, 0, 0, 0 };
+    int count = 0;
+    std::size_t pos = 0;
+    while (pos < stemEnd && count < 6) {
+        if (!parseNumber(pos, stemEnd, fields[count++])) {
+            return false;
+        }
+        if (pos < stemEnd && fileName[pos++] != '-') {
+            return false;
+        }
+    }
+    if (pos != stemEnd || count < 3) {
+        return false;
+    }
+
+    std::tm timeInfo{};
+    timeInfo.tm_year = fields[0] - 1900;
+    timeInfo.tm_mon = fields[1] - 1;
+    timeInfo.tm_mday = fields[2];
+    timeInfo.tm_hour = fields[3];
+    timeInfo.tm_min = fields[4];
+    timeInfo.tm_sec = fields[5];
+    timeInfo.tm_isdst = -1;
+    startTime = std::mktime(&timeInfo);
+    return startTime != -1;
+}
+
+/**
+ * @brief Builds the retention index from the manifest, or else from the log
+ * files in the log directory; the directory is only scanned when there is no
+ * manifest or, after a crash, when the manifest is behind the directory.
+ * Afterwards the index is maintained in memory.
+ * Files are ordered by the start time and part number encoded in their names (oldest first).
+ * Resumes the active file of the previous run if its period has not ended,
+ * and marks the manifest unclean until the next clean shutdown.
  */
-void CircularLogger::rotateLogs() {
-    std::vector<fs::path> logFiles;
-    for (const auto& entry : fs::directory_iterator(logDirectory)) {
-        if (entry.is_regular_file()) {
-            logFiles.push_back(entry.path());
+void CircularLogger::loadRetainedFiles() {
+    retainedFiles.clear();
+    retainedBytes = 0;
+    LogManifest manifest;
+    bool haveManifest = manifest.load(logDirectory);
+    if (haveManifest && manifest.clean) {
+        for (const LogManifest::Entry& file : manifest.files) {
+            retainedFiles.push_back({ fs::path(logDirectory) / file.name, file.startTime, file.sequence, file.size });
+            retainedBytes += file.size;
         }
     }
-    // Sort files based on their last modified time (oldest first)
-    std::sort(logFiles.begin(), logFiles.end(), [](const fs::path& a, const fs::path& b) {
-        return fs::last_write_time(a) < fs::last_write_time(b);
+    else if (!haveManifest || !adoptUncleanManifest(manifest)) {
+        retainedFiles.clear();
+        retainedBytes = 0;
+        scanLogDirectory();
+    }
+
+    // Continue numbering parts after the newest existing file
+    if (!retainedFiles.empty()) {
+        const RetainedLogFile& newest = retainedFiles.back();
+        std::string name = newest.path.filename().string();
+        currentPeriodName = name.substr(0, name.find('.')) + ".log";
+        // A compressed file cannot be resumed, so its period continues with a new part
+        currentSequence = isCompressed(newest) ? newest.sequence + 1 : newest.sequence;
+    }
+
+    // Files retired before a restart may not have been compressed yet; the
+    // newest one is handled by rotateLogs() as it may still be resumed
+    if (compressRetiredFiles) {
+        for (std::size_t i = 0; i + 1 < retainedFiles.size(); ++i) {
+            compressRetiredFile(retainedFiles[i]);
+        }
+    }
+
+    if (haveManifest) {
+        resumeActiveFile(manifest);
+    }
+    saveManifest(false);
+}
+
+/**
+ * @brief Indexes the log files in the log directory. Used when the previous
+ * run did not shut down cleanly, so the newest file, which the previous run
+ * may have been writing when it stopped, is also cut back to its last
+ * complete record.
+ */
+void CircularLogger::scanLogDirectory() {
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(logDirectory, error)) {
+        std::time_t startTime;
+        int sequence;
+        if (entry.is_regular_file() && parseLogFileName(entry.path().filename().string(), startTime, sequence)) {
+            fs::path compressed = entry.path();
+            compressed += Housekeeper::compressedExtension;
+            if (fs::exists(compressed, error)) {
+                // Compression finished but deleting the original did not
+                housekeeper->submit(HousekeepingAction::Remove, entry.path());
+                continue;
+            }
+            std::uint64_t size = entry.file_size(error);
+            retainedFiles.push_back({ entry.path(), startTime, sequence, error ? 0 : size });
+            retainedBytes += retainedFiles.back().size;
+        }
+    }
+    std::sort(retainedFiles.begin(), retainedFiles.end(), [](const RetainedLogFile& a, const RetainedLogFile& b) {
+        return a.startTime != b.startTime ? a.startTime < b.startTime : a.sequence < b.sequence;
         });
 
-    // Remove oldest files if we exceed the max allowed entries
-    while (logFiles.size() >= maxEntries) {
-        fs::remove(logFiles.front());
-        logFiles.erase(logFiles.begin());
+    if (!retainedFiles.empty() && !isCompressed(retainedFiles.back())) {
+        RetainedLogFile& newest = retainedFiles.back();
+        std::uint64_t size = LogManifest::truncateTornTail(newest.path);
+        retainedBytes -= newest.size - size;
+        newest.size = size;
+    }
+}
+
+/**
+ * @brief Takes the retention index from the manifest of a run that crashed,
+ * checking only a few files instead of scanning the directory. The manifest
+ * is written after the deletions and compressions queued before it, so
+ * its list matches the directory unless a later rotation's manifest was lost;
+ * such a rotation left a file after the active one, either its next part or
+ * the file of the period that starts at the rotation deadline. Entries at the
+ * front whose deletion or compression failed are corrected, and the active
+ * file is cut back to its last complete record.
+ * @param manifest The unclean manifest.
+ * @return false if the directory has to be scanned.
+ */
+bool CircularLogger::adoptUncleanManifest(const LogManifest& manifest) {
+    const LoggerSettings& current = settings();
+    if (manifest.files.empty() || manifest.activeFile.empty() || manifest.files.back().name != manifest.activeFile
+        || manifest.rotationUnit != static_cast<int>(current.rotationUnit) || manifest.frequency != current.frequency) {
+        return false;
+    }
+    fs::path directory = logDirectory;
+    std::error_code error;
+    if (!fs::exists(directory / manifest.activeFile, error)) {
+        return false;
+    }
+    std::string period = manifest.periodName.substr(0, manifest.periodName.find('.'));
+    std::tm deadline;
+    TimestampCache::toLocalTime(manifest.nextRotationTime, deadline);
+    if (fs::exists(directory / (period + "." + std::to_string(manifest.sequence + 1) + ".log"), error)
+        || fs::exists(directory / generateLogFileName(deadline, 0), error)) {
+        return false;
+    }
+
+    for (const LogManifest::Entry& file : manifest.files) {
+        retainedFiles.push_back({ directory / file.name, file.startTime, file.sequence, file.size });
+        retainedBytes += file.size;
+    }
+    // Evictions take the oldest files, so a deletion that failed or a compression
+    // that left the original can only show at the front
+    while (retainedFiles.size() > 1 && !fs::exists(retainedFiles.front().path, error)) {
+        RetainedLogFile& oldest = retainedFiles.front();
+        fs::path original = oldest.path;
+        if (isCompressed(oldest) && fs::exists(original.replace_extension(), error)) {
+            oldest.path = original;
+            break;
+        }
+        retainedBytes -= oldest.size;
+        retainedFiles.erase(retainedFiles.begin());
+    }
+    RetainedLogFile& newest = retainedFiles.back();
+    std::uint64_t size = LogManifest::truncateTornTail(newest.path);
+    retainedBytes += size - newest.size;
+    newest.size = size;
+    return true;
+}
+
+/**
+ * @brief Continues appending to the file the previous run was writing, so a
+ * restart within a rotation period neither starts a new file nor evicts an
+ * old one. Only done if the manifest was written with the current format and
+ * rotation settings and its rotation deadline is still ahead.
+ * @param manifest The manifest of the previous run.
+ */
+void CircularLogger::resumeActiveFile(const LogManifest& manifest) {
+    const LoggerSettings& current = settings();
+    if (manifest.activeFile.empty() || manifest.format != static_cast<int>(logFormat)
+        || manifest.rotationUnit != static_cast<int>(current.rotationUnit) || manifest.frequency != current.frequency
+        || manifest.nextRotationTime <= std::chrono::system_clock::to_time_t(clock.now())) {
+        return;
+    }
+    if (retainedFiles.empty() || isCompressed(retainedFiles.back()) || retainedFiles.back().path.filename() != manifest.activeFile) {
+        return;
+    }
+    RetainedLogFile& active = retainedFiles.back();
+    std::error_code error;
+    std::uint64_t size = fs::file_size(active.path, error);
+    if (error) {
+        return;
+    }
+    retainedBytes += size - active.size;
+    active.size = size;
+    currentLogFile = active.path;
+    currentFileBytes = size;
+    resumeIndex(active.path);
+    currentPeriodName = manifest.periodName;
+    currentSequence = manifest.sequence;
+    openLogFile();
+    nextRotationTime.store(manifest.nextRotationTime, std::memory_order_release);
+}
+
+/**
+ * @brief Records the active file, its rotation deadline and the retention
+ * index in the manifest. Only the content is
+ * captured here; the housekeeping thread writes the file, in order with the
+ * deletions and compressions queued before it, so rotation does no file I/O
+ * for it. Must be called with fileMutex held or before logging starts.
+ * @param clean true when the logger is shutting down and nothing is written after this.
+ */
+void CircularLogger::saveManifest(bool clean) {
+    LogManifest manifest;
+    const LoggerSettings& current = settings();
+    manifest.clean = clean;
+    manifest.format = static_cast<int>(logFormat);
+    manifest.rotationUnit = static_cast<int>(current.rotationUnit);
+    manifest.frequency = current.frequency;
+    std::time_t deadline = nextRotationTime.load(std::memory_order_relaxed);
+    if (deadline > 0 && !currentLogFile.empty()) {
+        manifest.nextRotationTime = deadline;
+        manifest.activeFile = currentLogFile.filename().string();
+        manifest.periodName = currentPeriodName;
+        manifest.sequence = currentSequence;
+    }
+    manifest.files.reserve(retainedFiles.size());
+    for (const RetainedLogFile& file : retainedFiles) {
+        std::uint64_t size = file.path == currentLogFile ? currentFileBytes : file.size;
+        manifest.files.push_back({ file.path.filename().string(), file.startTime, file.sequence, size });
+    }
+    fs::path directory = logDirectory;
+    housekeeper->submitSave(directory / LogManifest::fileName,
+        [manifest = std::move(manifest), directory]() { return manifest.save(directory); });
+}
+
+/**
+ * @brief Writes the sidecar index of the current log file, so searches can
+ * seek into it and skip it. A copy of the index is handed to the
+ * housekeeping thread, which writes it; a later removal of the index, when
+ * the file is evicted, is queued after it. Must be called with fileMutex held.
+ */
+void CircularLogger::saveIndex() {
+    if (!indexing || currentLogFile.empty() || currentFileBytes == 0) {
+        return;
+    }
+    fs::path path = LogIndex::pathFor(currentLogFile);
+    housekeeper->submitSave(path, [index = logIndex, path, size = currentFileBytes]() { return index.save(path, size); });
+}
+
+/**
+ * @brief Picks up the index of a file that already has content and is
+ * appended to again: the saved one if it still matches the file, otherwise,
+ * e.g. after a crash, one rebuilt from the file's lines. Must be called with
+ * fileMutex held or before logging starts.
+ * @param file The log file being continued; currentFileBytes is its size.
+ */
+void CircularLogger::resumeIndex(const fs::path& file) {
+    if (!indexing) {
+        return;
+    }
+    if (logIndex.load(LogIndex::pathFor(file)) && logIndex.fileSize() == currentFileBytes) {
+        return;
+    }
+    if (!logIndex.rebuild(file)) {
+        logIndex.clear();
+    }
+}
+
+/**
+ * @brief Returns true if a retained file has already been handed to the compressor.
+ * @param file An entry of the retention index.
+ */
+bool CircularLogger::isCompressed(const RetainedLogFile& file) {
+    return file.path.extension() == Housekeeper::compressedExtension;
+}
+
+/**
+ * @brief Hands a retired file to the housekeeping thread for compression and
+ * points its index entry at the compressed name. The entry keeps the
+ * uncompressed size, so the byte budget overestimates until the next restart.
+ * @param file An entry of the retention index that is no longer written to.
+ */
+void CircularLogger::compressRetiredFile(RetainedLogFile& file) {
+    if (isCompressed(file)) {
+        return;
+    }
+    housekeeper->submit(HousekeepingAction::Compress, file.path, compressionLevel);
+    file.path += Housekeeper::compressedExtension;
+}
+
+/**
+ * @brief Rotates log files based on the maximum number of entries and total size.
+ * Must be called with fileMutex held.
+ * Closes the persistent log file, then deletes the oldest files so that,
+ * together with the next file, at most maxEntries log files are kept and,
+ * if maxTotalBytes is set, the retained files fit in that budget while
+ * leaving room for a full next file.
+ * Only the in-memory retention index is consulted, and deletions, compressions
+ * and the index of the retired file are handed to the housekeeping thread.
+ * The filesystem work left here is closing the retired file and, with a
+ * segment pool, renaming and emptying the evicted file that becomes the next
+ * one; startNextLogFile() then reserves its space and opens it.
+ * @param nextFile The file that becomes the current log file.
+ */
+void CircularLogger::rotateLogs(const RetainedLogFile& nextFile) {
+    // Release the active file first so it can be deleted if it is the oldest one
+    if (fileWriter->isOpen()) {
+        fileWriter->close();
+        discountLostBytes();
+    }
+
+    // Record the final size of the file being retired
+    if (!retainedFiles.empty() && retainedFiles.back().path == currentLogFile) {
+        retainedBytes += currentFileBytes - retainedFiles.back().size;
+        retainedFiles.back().size = currentFileBytes;
+        saveIndex();
+    }
+
+    // After a restart within the same period the next file may already be indexed
+    if (!retainedFiles.empty() && retainedFiles.back().path == nextFile.path) {
+        bool reopened = currentLogFile != nextFile.path;
+        currentFileBytes = retainedFiles.back().size;
+        if (reopened) {
+            resumeIndex(nextFile.path);
+        }
+        return;
+    }
+
+    // The retired file is complete; removal of an evicted one is queued after its compression
+    if (compressRetiredFiles && !retainedFiles.empty()) {
+        compressRetiredFile(retainedFiles.back());
+    }
+
+    // Remove oldest files if we exceed the limits; deletion runs on the housekeeping thread.
+    // With a segment pool the first evicted file becomes the next one instead, so once
+    // maxEntries files exist rotation is a rename and no file is created or deleted
+    const LoggerSettings& current = settings();
+    auto overBudget = [this, &current] {
+        return retainedFiles.size() >= static_cast<std::size_t>(current.maxEntries)
+            || (current.maxTotalBytes > 0 && retainedBytes + fileSizeLimit() > current.maxTotalBytes);
+    };
+    bool recycled = false;
+    while (!retainedFiles.empty() && overBudget()) {
+        if (segmentBytes > 0 && !recycled && LogFileWriter::recycle(retainedFiles.front().path, nextFile.path)) {
+            recycled = true;
+        }
+        else {
+            housekeeper->submit(HousekeepingAction::Remove, retainedFiles.front().path);
+        }
+        housekeeper->submit(HousekeepingAction::Remove, LogIndex::pathFor(retainedFiles.front().path));
+        retainedBytes -= retainedFiles.front().size;
+        retainedFiles.pop_front();
     }
+    retainedFiles.push_back(nextFile);
+    currentFileBytes = 0;
+    logIndex.clear();
 }
@@ -10,26 +10,447 @@
 #include <chrono>
 #include <ctime>
 #include <thread>
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <format>
+#include <initializer_list>
+#include <charconv>
+#include "BoundedQueue.h"
+#include "LogRecord.h"
+#include "LogCallSite.h"
+#include "LogClock.h"
+#include "LogLevel.h"
+#include "LoggerStats.h"
+#include "TimestampCache.h"
+#include "Housekeeper.h"
+#include "LogFileWriter.h"
+#include "LogIndex.h"
+#include "LogManifest.h"
+#include "NetworkSink.h"
+#include "FlightRecorder.h"
+#include "BinaryLogFormat.h"
+#include "JsonLineWriter.h"
+#include "ConfigWatcher.h"
+#include "WriterThread.h"
+#include <unordered_map>
+#include <vector>
+
+enum class RotationUnit {
+    Second,
+    Minute,
+    Hour,
+    Day
+};
+
+enum class LoggingMode {
+    Sync,           // write on the calling thread
+    Async,          // enqueue for the writer thread
+    FlightRecorder  // keep the last messages in memory, write on demand
+};
+
+enum class LogFormat {
+    Text,    // "2024-01-31 12:34:56 INFO - message" lines
+    Binary,  // BinaryLogFormat records, decoded with LogDecoder
+    Json     // one JSON object per line, see JsonLineWriter
+};
+
+enum class FlushPolicy {
+    EveryLine,  // flush after every message
+    Bytes,      // flush once flushBytes have been buffered
+    Interval    // flush once flushIntervalMs have elapsed since the last flush
+};
+
+enum class OverflowPolicy {
+    Block,       // wait for the writer thread to free a slot
+    DropNewest,  // discard the message being logged
+    DropOldest   // discard the oldest queued message to make room
+};
+
+struct RetainedLogFile {
+    std::filesystem::path path;
+    std::time_t startTime;
+    int sequence;        // part number within the period, 0 for the first file
+    std::uint64_t size;  // bytes, final once the file is no longer current
+};
+
+/**
+ * @brief The settings that can change while the logger runs.
+ * A snapshot is never modified once published; a reload publishes a new one.
+ */
+struct LoggerSettings {
+    LogLevel minimumLevel = LogLevel::Info;
+    LogLevel ringDumpLevel = LogLevel::Off;  // messages at or above this level dump the ring
+    RotationUnit rotationUnit = RotationUnit::Second;
+    int frequency = 5;
+    int maxEntries = 12;
+    std::uint64_t maxFileBytes = 0;   // 0 disables size-based rotation
+    std::uint64_t maxTotalBytes = 0;  // 0 disables the retention size budget
+    FlushPolicy flushPolicy = FlushPolicy::EveryLine;
+    std::size_t flushBytes = 4096;
+    int flushIntervalMs = 1000;
+    OverflowPolicy overflowPolicy = OverflowPolicy::Block;
+    TimestampPrecision timestampPrecision = TimestampPrecision::Seconds;
+    double rateLimitPerSecond = 0;    // per call site of the CLOG_*_LIMITED macros; 0 disables the limit
+    int rateLimitBurst = 10;
+};
+
+/**
+ * @brief Workers and defaults a logger takes from its owner instead of
+ * starting its own, so the channels of a LoggerRegistry share one writer
+ * thread and one housekeeping thread.
+ */
+struct LoggerContext {
+    WriterThread* writer = nullptr;            // drains the queue in "async" mode
+    Housekeeper* housekeeper = nullptr;        // deletes and compresses retired files
+    std::string defaultLogDirectory = "Logs";  // used when the configuration has no "logDirectory"
+    LogClock::NowFunction clock = nullptr;     // replaces the configured "clock" if set
+};
 
 class CircularLogger {
+    friend class WriterThread;
+
 public:
     CircularLogger(const std::string& configPath = "config.json");//default constructor
-    void log(const std::string& message);
+    CircularLogger(const std::string& configPath, const LoggerContext& context);
+    ~CircularLogger();
+    CircularLogger(const CircularLogger&) = delete;
+    CircularLogger& operator=(const CircularLogger&) = delete;
+    void log(std::string_view message);
+    void log(LogLevel level, std::string_view message);
+    void log(std::string_view message, std::initializer_list<LogField> fields);
+    void log(LogLevel level, std::string_view message, std::initializer_list<LogField> fields);
+
+    /**
+     * @brief Logs a std::format-style message at info level.
+     */
+    template <typename... Args>
+        requires (sizeof...(Args) > 0)
+    void log(std::format_string<Args...> format, Args&&... args) {
+        log(LogLevel::Info, format, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Logs a std::format-style message. The format string is checked at
+     * compile time and the text is formatted directly into the logger's buffer.
+     * With deferred formatting enabled, the arguments are only captured in
+     * binary form and the writer thread does the formatting.
+     * Messages below the current level are discarded before any formatting;
+     * use the CLOG_* macros to also skip evaluating the arguments.
+     */
+    template <typename... Args>
+        requires (sizeof...(Args) > 0)
+    void log(LogLevel level, std::format_string<Args...> format, Args&&... args) {
+        if (!shouldLog(level)) {
+            return;
+        }
+        if constexpr (ArgumentCodec::canEncode<Args...>()) {
+            if (deferredFormatting) {
+                logDeferred(level, format.get(), &ArgumentCodec::formatEncoded<Args...>, args...);
+                return;
+            }
+        }
+        logFormatted(level, format.get(), std::make_format_args(args...));
+    }
+
+    /**
+     * @brief Returns true if messages at level pass the runtime threshold.
+     */
+    bool shouldLog(LogLevel level) const {
+        return level >= settings().minimumLevel && level != LogLevel::Off;
+    }
+
+    /**
+     * @brief Level check plus the rate limit of one call site, see CLOG_LIMITED_AT_LEVEL.
+     * Before the first message admitted after a suppressed run it logs how
+     * many messages of the site were suppressed; runs that no message follows
+     * are reported by flush() and the destructor.
+     * @param site The call site's state.
+     * @param level The message's level.
+     * @return true if the message should be logged.
+     */
+    bool admit(LogCallSite& site, LogLevel level) {
+        const LoggerSettings& current = settings();
+        if (level < current.minimumLevel || level == LogLevel::Off) {
+            return false;
+        }
+        if (current.rateLimitPerSecond <= 0) {
+            return true;
+        }
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        if (!site.tryAcquire(current.rateLimitPerSecond, current.rateLimitBurst,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now).count())) {
+            messagesSuppressed.increment();
+            if (site.countSuppressed(this, level)) {
+                rememberSuppressedSite(site);
+            }
+            return false;
+        }
+        if (std::uint64_t repeated = site.takeSuppressed(this)) {
+            log(level, "last message repeated {} times", repeated);
+        }
+        return true;
+    }
+    void setLevel(LogLevel level);
+
+    /**
+     * @brief The settings currently in effect. The snapshot stays valid for the
+     * lifetime of the logger even if a newer one is published.
+     */
+    const LoggerSettings& settings() const {
+        return *activeSettings.load(std::memory_order_acquire);
+    }
+    void flush();
+    void dumpFlightRecorder();
+    std::uint64_t droppedMessages() const;
+    std::size_t housekeepingQueueDepth() const;
+    LoggerStats stats() const;
 
 private:
     std::string configPath;
-    std::string loggingType;
-    int frequency;
-    int maxEntries;
+    std::atomic<const LoggerSettings*> activeSettings{ nullptr };
+    std::mutex settingsMutex; // serializes publishing new settings
+    std::vector<std::unique_ptr<const LoggerSettings>> publishedSettings; // kept alive for readers of old snapshots
+    int configReloadMs = 1000;  // 0 disables watching the configuration file
+    std::unique_ptr<ConfigWatcher> configWatcher;
+    LogClock clock;
     std::string logDirectory = "Logs";
     std::filesystem::path currentLogFile;
-    std::time_t nextRotationTime=0;
+    std::deque<RetainedLogFile> retainedFiles; // oldest first, includes the current file
+    std::uint64_t retainedBytes = 0;
+    std::uint64_t currentFileBytes = 0;
+    std::string currentPeriodName;
+    int currentSequence = 0;
+    std::unique_ptr<Housekeeper> ownHousekeeper; // unless the context provides one
+    Housekeeper* housekeeper = nullptr;
+    bool compressRetiredFiles = false;
+    int compressionLevel = 3;
+    std::uint64_t segmentBytes = 0; // > 0: evicted files are renamed and emptied for reuse, and this much space is reserved per file
+    std::size_t indexCheckpointBytes = 64 * 1024; // 0 writes no index files
+    std::size_t indexBloomBytes = 0;              // 0 indexes times only, not words
+    bool indexing = false;                        // text and JSON files only
+    LogIndex logIndex;                            // of the current file, guarded by fileMutex
+    std::atomic<std::time_t> nextRotationTime{ 0 };
+    std::mutex fileMutex; // guards the current log file, its stream and the flush state
+    bool keepFileOpen = true;
+    LogFileWriterOptions writerOptions;
+    std::unique_ptr<LogFileWriter> fileWriter;
+    bool deferFlushes = false;  // set by the writer thread while it drains a batch
+    std::size_t unflushedBytes = 0;
+    std::chrono::steady_clock::time_point lastFlushTime;
+    LogFormat logFormat = LogFormat::Text;
+    std::unordered_map<const char*, std::uint32_t> formatIds; // binary format ids defined in the current file
+    std::uint32_t nextFormatId = 1;
+    NetworkSinkOptions networkOptions;
+    std::unique_ptr<NetworkSink> networkSink; // ships every text or JSON line if a "networkProtocol" is set
+
+    // Self-instrumentation: the message counters are per thread, the rest is updated
+    // under fileMutex or by the writer thread
+    ThreadLocalCounter messagesLogged;
+    ThreadLocalCounter messagesSuppressed;  // by the rate limit of a call site
+    std::mutex suppressedSitesMutex;
+    std::vector<LogCallSite*> suppressedSites;  // with suppressed runs that may not have been reported yet
+    StatCounter bytesWritten;
+    StatCounter writeErrors;  // appends the output backend did not take, or writes of earlier ones that failed
+    StatCounter queueHighWater;
+    LatencyRecorder writeLatency;  // every writeSampleInterval-th append
+    static constexpr unsigned writeSampleInterval = 16;
+    unsigned appendsSinceTimed = 0;
+    LatencyRecorder flushLatency;
+    LatencyRecorder rotationLatency;
+
+    LoggingMode mode = LoggingMode::Sync;
+
+    // Asynchronous mode: log() only enqueues, the writer thread does the rest
+    std::size_t queueCapacity = 8192;
+    std::size_t recordSlabCount = 256;   // blocks for messages longer than LogRecord::inlineCapacity; 0 uses the heap
+    std::size_t recordSlabBytes = 4096;
+    std::unique_ptr<SlabPool> recordSlabs;
+    std::unique_ptr<BoundedQueue<LogRecord>> queue;
+    std::unique_ptr<WriterThread> ownWriter; // unless the context provides one
+    WriterThread* writer = nullptr;
+    std::atomic<std::uint64_t> acceptedCount{ 0 };
+    std::atomic<std::uint64_t> processedCount{ 0 };
+    std::atomic<std::uint64_t> droppedCount{ 0 };
+    std::uint64_t flushTarget = 0;   // guarded by the writer's mutex
+    std::uint64_t flushedCount = 0;  // guarded by the writer's mutex
+    bool deferredFormatting = false;
+
+    // Flight recorder mode: log() only records into the in-memory ring
+    std::size_t ringCapacity = 4096;
+    std::size_t ringSlotBytes = 256;
+    bool ringCrashDump = true;
+    std::unique_ptr<FlightRecorder> flightRecorder;
+    std::mutex ringDumpMutex;
+    std::uint64_t ringDumpedUpTo = 0;        // ring position up to which entries were written, guarded by ringDumpMutex
 
     void loadConfig();
+    void reloadConfig();
+    static LoggerSettings parseSettings(const nlohmann::json& configJson);
+    void publishSettings(const LoggerSettings& next);
     void saveDefaultConfig();
     void ensureLogDirectory();
-    std::string generateLogFileName(const std::tm& timeInfo);
+    std::string generateLogFileName(const std::tm& timeInfo, int sequence);
     std::time_t calculateNextRotationTime(std::time_t currentTime);
-    void rotateLogs();
+    void rotateLogs(const RetainedLogFile& nextFile);
+    void startNextLogFile(const std::tm& timeInfo, std::time_t nowTime, bool sizeLimitReached);
+    void loadRetainedFiles();
+    void scanLogDirectory();
+    bool adoptUncleanManifest(const LogManifest& manifest);
+    void resumeActiveFile(const LogManifest& manifest);
+    void saveManifest(bool clean);
+    void saveIndex();
+    void resumeIndex(const std::filesystem::path& file);
+    static bool isCompressed(const RetainedLogFile& file);
+    void compressRetiredFile(RetainedLogFile& file);
+    static bool parseLogFileName(std::string_view fileName, std::time_t& startTime, int& sequence);
+    void openLogFile();
+    void writeRecord(std::chrono::system_clock::time_point now, LogLevel level, std::uint32_t threadId, std::string_view message,
+        std::string_view fields = std::string_view());
+    void writeBinaryRecord(std::chrono::system_clock::time_point now, LogLevel level, std::uint32_t threadId,
+        std::string_view format, std::string_view payload, std::string_view fields = std::string_view());
+    std::string_view renderFields(std::initializer_list<LogField> fields);
+    std::string& beginLine(std::chrono::system_clock::time_point now, LogLevel level);
+    void commitLine(std::chrono::system_clock::time_point now, LogLevel level);
+    void commitStaged(std::chrono::system_clock::time_point now, LogLevel level, std::string_view binaryFormat);
+    const std::tm& localTimeOf(std::chrono::system_clock::time_point now);
+    void prepareBinaryRecord(std::string_view format);
+    void logFormatted(LogLevel level, std::string_view format, std::format_args args);
+    void logEncoded(LogLevel level, std::string_view format, ArgumentCodec::Formatter formatter, std::string_view encodedArguments);
+    void recordInRing(std::chrono::system_clock::time_point now, LogLevel level, std::string_view message);
+    void writeDeferred(const LogRecord& record);
+
+    /**
+     * @brief Captures the arguments in binary form and enqueues them with the
+     * formatter instantiated for their types. The format string must outlive the
+     * logger, which compile-time format strings (string literals) always do.
+     */
+    template <typename... Args>
+    void logDeferred(LogLevel level, std::string_view format, ArgumentCodec::Formatter formatter, const Args&... args) {
+        thread_local std::string encoded;
+        encoded.resize(ArgumentCodec::encodedSize(args...));
+        ArgumentCodec::encode(reinterpret_cast<std::byte*>(encoded.data()), args...);
+        logEncoded(level, format, formatter, encoded);
+    }
+    std::uint64_t fileSizeLimit() const;
+    void appendLine(std::string_view line);
+    void flushStream();
+    void rememberSuppressedSite(LogCallSite& site);
+    void reportSuppressed();
+    void discountLostBytes();
+    void flushIfNeeded();
+    void enqueue(std::chrono::system_clock::time_point now, LogLevel level, std::string_view message);
+    template <typename Fill>
+    void enqueueWith(Fill&& fill);
+    void completeFlush();
+    bool serviceFlush();
+    std::chrono::milliseconds idleTimeout() const;
+    void flushOnInterval();
+    std::size_t drainQueue();
+    static RotationUnit parseRotationUnit(const std::string& name);
+    static LoggingMode parseLoggingMode(const std::string& name);
+    static LogFormat parseLogFormat(const std::string& name);
+    static LogLevel parseLogLevel(const std::string& name);
+    static FlushPolicy parseFlushPolicy(const std::string& name);
+    static OverflowPolicy parseOverflowPolicy(const std::string& name);
+    static TimestampPrecision parseTimestampPrecision(const std::string& name);
+    static ClockSource parseClockSource(const std::string& name);
+    static OutputMode parseOutputMode(const std::string& name);
+    static NetworkProtocol parseNetworkProtocol(const std::string& name);
 };
 
+/**
+ * Level-filtered logging. The arguments are only evaluated if the level is
+ * enabled at runtime, and levels below CIRCULARLOGGER_MIN_LEVEL compile to nothing:
+ *     CLOG_DEBUG(logger, "cache miss for {}", key);
+ */
+#define CLOG_AT_LEVEL(logger, level, ...) \
+    do { \
+        if ((logger).shouldLog(level)) { \
+            (logger).log(level, __VA_ARGS__); \
+        } \
+    } while (false)
+
+#if CIRCULARLOGGER_MIN_LEVEL <= CIRCULARLOGGER_LEVEL_TRACE
+#define CLOG_TRACE(logger, ...) CLOG_AT_LEVEL(logger, LogLevel::Trace, __VA_ARGS__)
+#else
+#define CLOG_TRACE(logger, ...) ((void)0)
+#endif
+
+#if CIRCULARLOGGER_MIN_LEVEL <= CIRCULARLOGGER_LEVEL_DEBUG
+#define CLOG_DEBUG(logger, ...) CLOG_AT_LEVEL(logger, LogLevel::Debug, __VA_ARGS__)
+#else
+#define CLOG_DEBUG(logger, ...) ((void)0)
+#endif
+
+#if CIRCULARLOGGER_MIN_LEVEL <= CIRCULARLOGGER_LEVEL_INFO
+#define CLOG_INFO(logger, ...) CLOG_AT_LEVEL(logger, LogLevel::Info, __VA_ARGS__)
+#else
+#define CLOG_INFO(logger, ...) ((void)0)
+#endif
+
+#if CIRCULARLOGGER_MIN_LEVEL <= CIRCULARLOGGER_LEVEL_WARN
+#define CLOG_WARN(logger, ...) CLOG_AT_LEVEL(logger, LogLevel::Warn, __VA_ARGS__)
+#else
+#define CLOG_WARN(logger, ...) ((void)0)
+#endif
+
+#if CIRCULARLOGGER_MIN_LEVEL <= CIRCULARLOGGER_LEVEL_ERROR
+#define CLOG_ERROR(logger, ...) CLOG_AT_LEVEL(logger, LogLevel::Error, __VA_ARGS__)
+#else
+#define CLOG_ERROR(logger, ...) ((void)0)
+#endif
+
+/**
+ * Rate-limited logging. Each call site gets its own token bucket, sized by
+ * "rateLimitPerSecond" and "rateLimitBurst"; messages over the limit are
+ * counted instead of formatted, and the next one that gets through is
+ * preceded by "last message repeated N times":
+ *     CLOG_ERROR_LIMITED(logger, "connection to {} failed: {}", host, error);
+ * The bucket belongs to the statement, not to a logger: a statement reached
+ * with different loggers shares one limit between them, checked against the
+ * settings of whichever logger is passed, and reports its suppressed count
+ * to the logger that next gets through. Give such statements one call site
+ * per logger.
+ */
+#define CLOG_LIMITED_AT_LEVEL(logger, level, ...) \
+    do { \
+        static LogCallSite clogCallSite{ __FILE__, __LINE__ }; \
+        if ((logger).admit(clogCallSite, level)) { \
+            (logger).log(level, __VA_ARGS__); \
+        } \
+    } while (false)
+
+#if CIRCULARLOGGER_MIN_LEVEL <= CIRCULARLOGGER_LEVEL_TRACE
+#define CLOG_TRACE_LIMITED(logger, ...) CLOG_LIMITED_AT_LEVEL(logger, LogLevel::Trace, __VA_ARGS__)
+#else
+#define CLOG_TRACE_LIMITED(logger, ...) ((void)0)
+#endif
+
+#if CIRCULARLOGGER_MIN_LEVEL <= CIRCULARLOGGER_LEVEL_DEBUG
+#define CLOG_DEBUG_LIMITED(logger, ...) CLOG_LIMITED_AT_LEVEL(logger, LogLevel::Debug, __VA_ARGS__)
+#else
+#define CLOG_DEBUG_LIMITED(logger, ...) ((void)0)
+#endif
+
+#if CIRCULARLOGGER_MIN_LEVEL <= CIRCULARLOGGER_LEVEL_INFO
+#define CLOG_INFO_LIMITED(logger, ...) CLOG_LIMITED_AT_LEVEL(logger, LogLevel::Info, __VA_ARGS__)
+#else
+#define CLOG_INFO_LIMITED(logger, ...) ((void)0)
+#endif
+
+#if CIRCULARLOGGER_MIN_LEVEL <= CIRCULARLOGGER_LEVEL_WARN
+#define CLOG_WARN_LIMITED(logger, ...) CLOG_LIMITED_AT_LEVEL(logger, LogLevel::Warn, __VA_ARGS__)
+#else
+#define CLOG_WARN_LIMITED(logger, ...) ((void)0)
+#endif
+
+#if CIRCULARLOGGER_MIN_LEVEL <= CIRCULARLOGGER_LEVEL_ERROR
+#define CLOG_ERROR_LIMITED(logger, ...) CLOG_LIMITED_AT_LEVEL(logger, LogLevel::Error, __VA_ARGS__)
+#else
+#define CLOG_ERROR_LIMITED(logger, ...) ((void)0)
+#endif
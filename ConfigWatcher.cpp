@@ -0,0 +1,61 @@
+#include "ConfigWatcher.h"
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Constructor for ConfigWatcher. Records the current state of the file
+ * and starts polling it.
+ * @param path The file to watch.
+ * @param interval Time between two checks.
+ * @param onChange Called on the watcher thread after each detected change.
+ */
+ConfigWatcher::ConfigWatcher(const fs::path& path, std::chrono::milliseconds interval, std::function<void()> onChange)
+    : path(path), interval(interval), onChange(std::move(onChange)) {
+    changed();
+    worker = std::thread(&ConfigWatcher::run, this);
+}
+
+/**
+ * @brief Destructor. Stops the watcher thread; a callback in progress completes first.
+ */
+ConfigWatcher::~ConfigWatcher() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopRequested = true;
+    }
+    stopSignal.notify_one();
+    worker.join();
+}
+
+/**
+ * @brief Compares the file's modification time and size with the last check.
+ * @return true if either differs.
+ */
+bool ConfigWatcher::changed() {
+    std::error_code error;
+    fs::file_time_type writeTime = fs::last_write_time(path, error);
+    if (error) {
+        return false;
+    }
+    std::uintmax_t size = fs::file_size(path, error);
+    if (error || (writeTime == lastWriteTime && size == lastSize)) {
+        return false;
+    }
+    lastWriteTime = writeTime;
+    lastSize = size;
+    return true;
+}
+
+/**
+ * @brief Body of the watcher thread.
+ */
+void ConfigWatcher::run() {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    while (!stopSignal.wait_for(lock, interval, [this] { return stopRequested; })) {
+        lock.unlock();
+        if (changed()) {
+            onChange();
+        }
+        lock.lock();
+    }
+}
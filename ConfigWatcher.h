@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief Polls a file on a background thread and reports when it changes.
+ * A change is a different modification time or size; a file that disappears
+ * is not reported. Polling works the same on every platform and on network
+ * shares, and the interval bounds how stale the configuration can get.
+ */
+class ConfigWatcher {
+public:
+    ConfigWatcher(const std::filesystem::path& path, std::chrono::milliseconds interval, std::function<void()> onChange);
+    ~ConfigWatcher();
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+private:
+    std::filesystem::path path;
+    std::chrono::milliseconds interval;
+    std::function<void()> onChange;
+    std::filesystem::file_time_type lastWriteTime{};
+    std::uintmax_t lastSize = 0;
+    std::mutex stopMutex;
+    std::condition_variable stopSignal;
+    bool stopRequested = false;
+    std::thread worker;
+
+    bool changed();
+    void run();
+};
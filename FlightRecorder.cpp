@@ -0,0 +1,285 @@
+#include "FlightRecorder.h"
+
+#include <csignal>
+#include <cstring>
+#include <iterator>
+#include <new>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    constexpr std::size_t maxCrashRecorders = 16;
+    std::atomic<FlightRecorder*> crashRecorders[maxCrashRecorders];
+
+    constexpr int fatalSignals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+
+    // What handled each fatal signal before installCrashHandler(), restored after a dump
+    std::atomic<bool> crashHandlerInstalled{ false };
+#ifdef _WIN32
+    void (*previousHandlers[std::size(fatalSignals)])(int);
+#else
+    struct sigaction previousHandlers[std::size(fatalSignals)];
+#endif
+
+    /**
+     * @brief Writes a buffer to a raw descriptor; async-signal-safe.
+     */
+    void writeRaw(int fd, const char* data, std::size_t size) {
+#ifdef _WIN32
+        _write(fd, data, static_cast<unsigned>(size));
+#else
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written <= 0) {
+                return;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+#endif
+    }
+
+    void writeDigits(char* out, std::int64_t value, int count) {
+        for (int i = count - 1; i >= 0; --i) {
+            out[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+    /**
+     * @brief Formats "YYYY-MM-DD HH:MM:SS.uuuuuu" in UTC without calling into the C runtime.
+     * Local time conversion is not async-signal-safe, so crash dumps use UTC.
+     * @return Number of characters written (26).
+     */
+    std::size_t formatUtc(char* out, std::int64_t timeMicros) {
+        std::int64_t seconds = timeMicros >= 0 ? timeMicros / 1000000 : (timeMicros - 999999) / 1000000;
+        std::int64_t micros = timeMicros - seconds * 1000000;
+        std::int64_t days = seconds >= 0 ? seconds / 86400 : (seconds - 86399) / 86400;
+        std::int64_t secondOfDay = seconds - days * 86400;
+
+        // Civil date from days since 1970-01-01 (Howard Hinnant's algorithm)
+        days += 719468;
+        std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        std::int64_t dayOfEra = days - era * 146097;
+        std::int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        std::int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        std::int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+        std::int64_t day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+        std::int64_t month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+        std::int64_t year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+
+        writeDigits(out, year, 4);
+        out[4] = '-';
+        writeDigits(out + 5, month, 2);
+        out[7] = '-';
+        writeDigits(out + 8, day, 2);
+        out[10] = ' ';
+        writeDigits(out + 11, secondOfDay / 3600, 2);
+        out[13] = ':';
+        writeDigits(out + 14, secondOfDay / 60 % 60, 2);
+        out[16] = ':';
+        writeDigits(out + 17, secondOfDay % 60, 2);
+        out[19] = '.';
+        writeDigits(out + 20, micros, 6);
+        return 26;
+    }
+
+}
+
+/**
+ * @brief Constructor for FlightRecorder. Allocates every slot up front.
+ * @param capacity Number of messages retained.
+ * @param slotBytes Maximum stored length of a message.
+ */
+FlightRecorder::FlightRecorder(std::size_t capacity, std::size_t slotBytes)
+    : capacity(capacity > 0 ? capacity : 1), slotBytes(slotBytes) {
+    // Round each slot up to a cache line so concurrent writers do not share lines
+    slotStride = (sizeof(SlotHeader) + slotBytes + 63) / 64 * 64;
+    slab = std::make_unique<std::byte[]>(this->capacity * slotStride);
+    for (std::size_t i = 0; i < this->capacity; ++i) {
+        new (slab.get() + i * slotStride) SlotHeader{ {0}, 0, 0, LogLevel::Info };
+    }
+}
+
+/**
+ * @brief Destructor. Unregisters the recorder from the crash handler.
+ */
+FlightRecorder::~FlightRecorder() {
+    for (auto& registered : crashRecorders) {
+        FlightRecorder* expected = this;
+        registered.compare_exchange_strong(expected, nullptr);
+    }
+}
+
+/**
+ * @brief Stores a message in the next slot, overwriting the oldest entry.
+ * If another thread is still writing the same slot (the ring wrapped during
+ * its copy), the message is dropped rather than waiting; so is a message whose
+ * producer was preempted long enough for a later lap to fill its slot.
+ * @param time The time the message was logged.
+ * @param level The severity of the message.
+ * @param message The message to store.
+ */
+void FlightRecorder::record(std::chrono::system_clock::time_point time, LogLevel level, std::string_view message) {
+    std::uint64_t pos = head.fetch_add(1, std::memory_order_relaxed);
+    SlotHeader* header = slot(pos);
+    std::uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+    do {
+        // A slot that is being written, or already holds a later lap, is left alone
+        if ((sequence & 1) != 0 || sequence >= 2 * pos + 1) {
+            return;
+        }
+    } while (!header->sequence.compare_exchange_weak(sequence, 2 * pos + 1, std::memory_order_acquire));
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::size_t length = message.size() < slotBytes ? message.size() : slotBytes;
+    header->timeMicros = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+    header->length = static_cast<std::uint32_t>(length);
+    header->level = level;
+    std::memcpy(reinterpret_cast<char*>(header + 1), message.data(), length);
+    header->sequence.store(2 * pos + 2, std::memory_order_release);
+}
+
+/**
+ * @brief Registers this recorder to be dumped to path if the process crashes.
+ * installCrashHandler() must be called for the dump to happen. Recorders
+ * registered with the same path are written one after another into that file.
+ * @param path File the retained messages are written to on a fatal signal.
+ */
+void FlightRecorder::enableCrashDump(const std::filesystem::path& path) {
+    crashDumpPath = path.string();
+    for (auto& registered : crashRecorders) {
+        FlightRecorder* expected = nullptr;
+        if (registered.compare_exchange_strong(expected, this)) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Installs handlers for fatal signals that dump every registered
+ * recorder and then pass the signal on to the handler that was installed
+ * before, such as the application's crash reporter, or to the default
+ * action. Only the first call installs anything, so later calls neither
+ * replace a handler the application set since nor lose the saved ones.
+ */
+void FlightRecorder::installCrashHandler() {
+    if (crashHandlerInstalled.exchange(true)) {
+        return;
+    }
+    for (std::size_t i = 0; i < std::size(fatalSignals); ++i) {
+#ifdef _WIN32
+        previousHandlers[i] = std::signal(fatalSignals[i], &FlightRecorder::handleFatalSignal);
+        if (previousHandlers[i] == SIG_ERR) {
+            previousHandlers[i] = SIG_DFL;
+        }
+#else
+        struct sigaction action {};
+        action.sa_handler = &FlightRecorder::handleFatalSignal;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(fatalSignals[i], &action, &previousHandlers[i]) != 0) {
+            previousHandlers[i].sa_handler = SIG_DFL;
+        }
+#endif
+    }
+}
+
+FlightRecorder::SlotHeader* FlightRecorder::slot(std::uint64_t pos) const {
+    return reinterpret_cast<SlotHeader*>(slab.get() + (pos % capacity) * slotStride);
+}
+
+/**
+ * @brief Copies one entry out of the ring if it is complete and still holds position pos.
+ * @return false if the entry was never written, is being written or was overwritten.
+ */
+bool FlightRecorder::read(std::uint64_t pos, std::int64_t& timeMicros, LogLevel& level, std::string& message) const {
+    const SlotHeader* header = slot(pos);
+    std::uint64_t expected = 2 * pos + 2;
+    if (header->sequence.load(std::memory_order_acquire) != expected) {
+        return false;
+    }
+    timeMicros = header->timeMicros;
+    level = header->level;
+    std::size_t length = header->length < slotBytes ? header->length : slotBytes;
+    message.assign(reinterpret_cast<const char*>(header + 1), length);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header->sequence.load(std::memory_order_relaxed) == expected;
+}
+
+/**
+ * @brief Writes the retained entries to crashDumpPath using only async-signal-safe calls.
+ * @param append true to add to a file another recorder of this crash has written.
+ */
+void FlightRecorder::dumpForCrash(bool append) const {
+#ifdef _WIN32
+    int fd = _open(crashDumpPath.c_str(), _O_WRONLY | _O_CREAT | (append ? _O_APPEND : _O_TRUNC) | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    int fd = ::open(crashDumpPath.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+#endif
+    if (fd < 0) {
+        return;
+    }
+    std::uint64_t end = head.load(std::memory_order_acquire);
+    std::uint64_t begin = end > capacity ? end - capacity : 0;
+    for (std::uint64_t pos = begin; pos < end; ++pos) {
+        const SlotHeader* header = slot(pos);
+        if (header->sequence.load(std::memory_order_acquire) != 2 * pos + 2) {
+            continue;
+        }
+        char prefix[48];
+        std::size_t prefixLength = formatUtc(prefix, header->timeMicros);
+        std::memcpy(prefix + prefixLength, " UTC ", 5);
+        prefixLength += 5;
+        std::string_view levelName = logLevelName(header->level);
+        std::memcpy(prefix + prefixLength, levelName.data(), levelName.size());
+        prefixLength += levelName.size();
+        std::memcpy(prefix + prefixLength, " - ", 3);
+        writeRaw(fd, prefix, prefixLength + 3);
+        writeRaw(fd, reinterpret_cast<const char*>(header + 1), header->length < slotBytes ? header->length : slotBytes);
+        writeRaw(fd, "\n", 1);
+    }
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+/**
+ * @brief Fatal signal handler: dumps all registered recorders, then restores
+ * the previous handler of the signal and re-raises it. The signal is blocked
+ * while this runs, so the previous handler receives it once this returns.
+ */
+void FlightRecorder::handleFatalSignal(int signal) {
+    for (std::size_t i = 0; i < maxCrashRecorders; ++i) {
+        FlightRecorder* recorder = crashRecorders[i].load();
+        if (recorder == nullptr) {
+            continue;
+        }
+        bool append = false;
+        for (std::size_t j = 0; j < i; ++j) {
+            FlightRecorder* earlier = crashRecorders[j].load();
+            append = append || (earlier != nullptr && earlier->crashDumpPath == recorder->crashDumpPath);
+        }
+        recorder->dumpForCrash(append);
+    }
+    for (std::size_t i = 0; i < std::size(fatalSignals); ++i) {
+        if (fatalSignals[i] == signal) {
+#ifdef _WIN32
+            std::signal(signal, previousHandlers[i]);
+#else
+            sigaction(signal, &previousHandlers[i], nullptr);
+#endif
+        }
+    }
+    std::raise(signal);
+}
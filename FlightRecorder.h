@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "LogLevel.h"
+
+/**
+ * @brief Fixed-size in-memory ring holding the most recent log messages.
+ * All slots are allocated up front; recording a message is one fetch_add and a
+ * memcpy into its slot, and older messages are silently overwritten. Messages
+ * longer than a slot are truncated. Each slot is guarded by its own sequence
+ * number so readers can copy entries out while producers keep recording.
+ */
+class FlightRecorder {
+public:
+    FlightRecorder(std::size_t capacity, std::size_t slotBytes);
+    ~FlightRecorder();
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    void record(std::chrono::system_clock::time_point time, LogLevel level, std::string_view message);
+
+    /**
+     * @brief Calls visit(time, level, message) for every retained entry recorded
+     * at or after position from, oldest first. Entries overwritten while the
+     * dump runs are skipped.
+     * @return The position to pass as from to visit only newer entries next time.
+     */
+    template <typename Visit>
+    std::uint64_t forEach(std::uint64_t from, Visit&& visit) const {
+        std::string message;
+        message.reserve(slotBytes);
+        std::uint64_t end = head.load(std::memory_order_acquire);
+        std::uint64_t begin = end > capacity ? end - capacity : 0;
+        for (std::uint64_t pos = begin > from ? begin : from; pos < end; ++pos) {
+            std::int64_t timeMicros;
+            LogLevel level;
+            if (read(pos, timeMicros, level, message)) {
+                visit(std::chrono::system_clock::time_point(std::chrono::microseconds(timeMicros)), level, std::string_view(message));
+            }
+        }
+        return end;
+    }
+
+    void enableCrashDump(const std::filesystem::path& path);
+    static void installCrashHandler();
+
+private:
+    struct SlotHeader {
+        std::atomic<std::uint64_t> sequence; // 2*pos+1 while writing, 2*pos+2 once complete
+        std::int64_t timeMicros;
+        std::uint32_t length;
+        LogLevel level;
+    };
+
+    std::size_t capacity;
+    std::size_t slotBytes;
+    std::size_t slotStride;
+    std::unique_ptr<std::byte[]> slab;
+    alignas(64) std::atomic<std::uint64_t> head{ 0 };
+    std::string crashDumpPath;
+
+    SlotHeader* slot(std::uint64_t pos) const;
+    bool read(std::uint64_t pos, std::int64_t& timeMicros, LogLevel& level, std::string& message) const;
+    void dumpForCrash(bool append) const;
+    static void handleFatalSignal(int signal);
+};
@@ -0,0 +1,190 @@
+#include "Housekeeper.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#if CIRCULARLOGGER_HAS_ZSTD
+#include <zstd.h>
+#if defined(_MSC_VER)
+#pragma comment(lib, "zstd.lib")
+#endif
+#endif
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Constructor for Housekeeper. Starts the worker thread.
+ */
+Housekeeper::Housekeeper() : worker(&Housekeeper::run, this) {
+}
+
+/**
+ * @brief Destructor. Waits for every queued task to finish, then stops the worker.
+ */
+Housekeeper::~Housekeeper() {
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        stopRequested = true;
+    }
+    tasksAvailable.notify_one();
+    worker.join();
+}
+
+/**
+ * @brief Queues a task for the worker thread and returns immediately.
+ * @param action The operation to perform.
+ * @param path The file the operation applies to.
+ * @param compressionLevel For Compress, a zstd level; 3 is zstd's default, 1 the fastest.
+ */
+void Housekeeper::submit(HousekeepingAction action, const fs::path& path, int compressionLevel) {
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        tasks.push_back({ action, path, compressionLevel, nullptr });
+        pendingCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    tasksAvailable.notify_one();
+}
+
+/**
+ * @brief Queues the write of a state file. The function must own everything
+ * it writes, as it runs after the caller has moved on; tasks keep their order,
+ * so a later save of the same file always wins.
+ * @param path The file the function writes, for error reports.
+ * @param save Writes the file and returns false on failure.
+ */
+void Housekeeper::submitSave(const fs::path& path, std::function<bool()> save) {
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        tasks.push_back({ HousekeepingAction::Save, path, 0, std::move(save) });
+        pendingCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    tasksAvailable.notify_one();
+}
+
+/**
+ * @brief Returns the number of tasks queued or in progress.
+ * A steadily growing value means housekeeping is falling behind rotation.
+ */
+std::size_t Housekeeper::queueDepth() const {
+    return pendingCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns true if the build found zstd, i.e. Compress tasks can succeed.
+ */
+bool Housekeeper::compressionAvailable() {
+    return CIRCULARLOGGER_HAS_ZSTD != 0;
+}
+
+/**
+ * @brief Body of the worker thread.
+ */
+void Housekeeper::run() {
+    std::unique_lock<std::mutex> lock(tasksMutex);
+    for (;;) {
+        tasksAvailable.wait(lock, [this] { return stopRequested || !tasks.empty(); });
+        if (tasks.empty()) {
+            break;
+        }
+        HousekeepingTask task = std::move(tasks.front());
+        tasks.pop_front();
+        lock.unlock();
+        perform(task);
+        pendingCount.fetch_sub(1, std::memory_order_relaxed);
+        lock.lock();
+    }
+}
+
+/**
+ * @brief Executes a single task. Failures are reported and otherwise ignored.
+ * @param task The task to execute.
+ */
+void Housekeeper::perform(const HousekeepingTask& task) {
+    std::error_code error;
+    switch (task.action) {
+    case HousekeepingAction::Remove:
+        fs::remove(task.path, error);
+        if (!error && task.path.extension() == compressedExtension) {
+            // If compressing the file failed, the uncompressed original is what is left
+            fs::path original = task.path;
+            fs::remove(original.replace_extension(), error);
+        }
+        break;
+    case HousekeepingAction::Compress:
+        compress(task.path, task.compressionLevel, error);
+        break;
+    case HousekeepingAction::Save:
+        if (!task.save()) {
+            error = std::make_error_code(std::errc::io_error);
+        }
+        break;
+    }
+    if (error) {
+        std::cerr << "Housekeeping failed for " << task.path << ": " << error.message() << std::endl;
+    }
+}
+
+/**
+ * @brief Streams a file through zstd into "<path>.zst", then deletes the original.
+ * The output is written under a temporary name and renamed once complete, so a
+ * ".zst" file is never partial; on failure the original is left in place.
+ * @param path The retired log file.
+ * @param level The zstd compression level.
+ * @param error Receives the reason if the file could not be compressed.
+ */
+void Housekeeper::compress(const fs::path& path, int level, std::error_code& error) {
+#if CIRCULARLOGGER_HAS_ZSTD
+    fs::path target = path;
+    target += compressedExtension;
+    fs::path partial = target;
+    partial += ".tmp";
+
+    bool completed = false;
+    {
+        std::ifstream input(path, std::ios::binary);
+        std::ofstream output(partial, std::ios::binary | std::ios::trunc);
+        std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+        if (input && output && context) {
+            ZSTD_CCtx_setParameter(context.get(), ZSTD_c_compressionLevel, level);
+            std::vector<char> inputBuffer(ZSTD_CStreamInSize());
+            std::vector<char> outputBuffer(ZSTD_CStreamOutSize());
+            bool failed = false;
+            bool lastChunk = false;
+            while (!failed && !lastChunk) {
+                input.read(inputBuffer.data(), static_cast<std::streamsize>(inputBuffer.size()));
+                lastChunk = input.eof();
+                failed = input.bad();
+                ZSTD_inBuffer chunk{ inputBuffer.data(), static_cast<std::size_t>(input.gcount()), 0 };
+                ZSTD_EndDirective directive = lastChunk ? ZSTD_e_end : ZSTD_e_continue;
+                bool chunkDone = false;
+                while (!failed && !chunkDone) {
+                    ZSTD_outBuffer compressed{ outputBuffer.data(), outputBuffer.size(), 0 };
+                    std::size_t remaining = ZSTD_compressStream2(context.get(), &compressed, &chunk, directive);
+                    failed = ZSTD_isError(remaining) != 0;
+                    output.write(outputBuffer.data(), static_cast<std::streamsize>(compressed.pos));
+                    // The last chunk is done once the frame is flushed, the others once consumed
+                    chunkDone = lastChunk ? remaining == 0 : chunk.pos == chunk.size;
+                }
+            }
+            output.close();
+            completed = !failed && output.good();
+        }
+    }
+
+    if (!completed) {
+        fs::remove(partial, error);
+        error = std::make_error_code(std::errc::io_error);
+        return;
+    }
+    fs::rename(partial, target, error);
+    if (!error) {
+        fs::remove(path, error);
+    }
+#else
+    (void)path;
+    (void)level;
+    error = std::make_error_code(std::errc::not_supported);
+#endif
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#if __has_include(<zstd.h>)
+#define CIRCULARLOGGER_HAS_ZSTD 1
+#else
+#define CIRCULARLOGGER_HAS_ZSTD 0
+#endif
+
+enum class HousekeepingAction {
+    Remove,   // delete a file that fell out of retention
+    Compress, // replace a retired file with "<name>.zst"
+    Save      // write a state file, such as the manifest or an index, whose content the logger captured
+};
+
+struct HousekeepingTask {
+    HousekeepingAction action;
+    std::filesystem::path path;
+    int compressionLevel;  // zstd level for Compress
+    std::function<bool()> save;  // Save: writes path, false on failure
+};
+
+/**
+ * @brief Background worker for file maintenance that must not block log().
+ * Tasks are processed in submission order on a dedicated thread; the
+ * destructor finishes all pending tasks before returning. Several loggers may
+ * share one Housekeeper, each passing its own compression level.
+ */
+class Housekeeper {
+public:
+    Housekeeper();
+    ~Housekeeper();
+    Housekeeper(const Housekeeper&) = delete;
+    Housekeeper& operator=(const Housekeeper&) = delete;
+
+    void submit(HousekeepingAction action, const std::filesystem::path& path, int compressionLevel = 3);
+    void submitSave(const std::filesystem::path& path, std::function<bool()> save);
+    std::size_t queueDepth() const;
+    static bool compressionAvailable();
+    static constexpr const char* compressedExtension = ".zst";
+
+private:
+    std::deque<HousekeepingTask> tasks;
+    std::mutex tasksMutex;
+    std::condition_variable tasksAvailable;
+    std::atomic<std::size_t> pendingCount{ 0 };
+    bool stopRequested = false;
+    std::thread worker;
+
+    void run();
+    void perform(const HousekeepingTask& task);
+    void compress(const std::filesystem::path& path, int level, std::error_code& error);
+};
@@ -0,0 +1,167 @@
+#include "JsonLineWriter.h"
+
+#include <charconv>
+#include <cmath>
+
+namespace {
+
+    constexpr char hexDigits[] = "0123456789abcdef";
+
+    // Characters that cannot appear unescaped inside a JSON string
+    bool needsEscape(char c) {
+        return static_cast<unsigned char>(c) < 0x20 || c == '"' || c == '\\';
+    }
+
+    // Whether a key=value string value must be quoted to be read back unambiguously
+    bool needsQuotes(std::string_view text) {
+        if (text.empty()) {
+            return true;
+        }
+        for (char c : text) {
+            if (c == ' ' || c == '=' || needsEscape(c)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+}
+
+/**
+ * @brief Appends text with JSON string escaping, without the surrounding quotes.
+ * Runs of characters that need no escaping are copied in one piece; bytes from
+ * 0x80 up are passed through, so UTF-8 text stays as it is.
+ * @param out Buffer to append to.
+ * @param text The text to escape.
+ */
+void JsonLineWriter::appendEscaped(std::string& out, std::string_view text) {
+    std::size_t runStart = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (!needsEscape(c)) {
+            continue;
+        }
+        out.append(text.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        default: {
+            char escape[6] = { '\\', 'u', '0', '0', hexDigits[(c >> 4) & 0xf], hexDigits[c & 0xf] };
+            out.append(escape, sizeof(escape));
+            break;
+        }
+        }
+    }
+    out.append(text.data() + runStart, text.size() - runStart);
+}
+
+/**
+ * @brief Appends text as a quoted JSON string.
+ * @param out Buffer to append to.
+ * @param text The text to write.
+ */
+void JsonLineWriter::appendString(std::string& out, std::string_view text) {
+    out += '"';
+    appendEscaped(out, text);
+    out += '"';
+}
+
+/**
+ * @brief Starts a record: appends the time, level and thread members and the
+ * opening of the "message" string. The caller appends the escaped message,
+ * then a closing quote, appendFields() and the closing brace.
+ * @param out Buffer to append to.
+ * @param time The formatted timestamp; it contains no characters that need escaping.
+ * @param level The level name.
+ * @param threadId Number of the thread that logged the message.
+ */
+void JsonLineWriter::appendRecordStart(std::string& out, std::string_view time, std::string_view level, std::uint32_t threadId) {
+    out += "{\"time\":\"";
+    out += time;
+    out += "\",\"level\":\"";
+    out += level;
+    out += "\",\"thread\":";
+    char digits[16];
+    out.append(digits, std::to_chars(digits, digits + sizeof(digits), threadId).ptr);
+    out += ",\"message\":\"";
+}
+
+/**
+ * @brief Appends each field as a JSON member, every one preceded by a comma.
+ * Non-finite numbers, which JSON cannot represent, are written as null.
+ * @param out Buffer to append to.
+ * @param fields The fields to write, in order.
+ */
+void JsonLineWriter::appendFields(std::string& out, std::initializer_list<LogField> fields) {
+    for (const LogField& field : fields) {
+        out += ',';
+        appendString(out, field.key);
+        out += ':';
+        if (field.type == LogField::Type::String) {
+            appendString(out, field.text);
+        }
+        else {
+            appendNumber(out, field, true);
+        }
+    }
+}
+
+/**
+ * @brief Appends each field as " key=value" for text files. String values
+ * that are empty or contain spaces, '=', quotes or control characters are
+ * quoted and escaped as in JSON.
+ * @param out Buffer to append to.
+ * @param fields The fields to write, in order.
+ */
+void JsonLineWriter::appendKeyValues(std::string& out, std::initializer_list<LogField> fields) {
+    for (const LogField& field : fields) {
+        out += ' ';
+        out += field.key;
+        out += '=';
+        if (field.type != LogField::Type::String) {
+            appendNumber(out, field, false);
+        }
+        else if (needsQuotes(field.text)) {
+            appendString(out, field.text);
+        }
+        else {
+            out += field.text;
+        }
+    }
+}
+
+/**
+ * @brief Appends a boolean or numeric field value with std::to_chars.
+ * @param out Buffer to append to.
+ * @param field A field that is not a string.
+ * @param json true to write non-finite numbers as null.
+ */
+void JsonLineWriter::appendNumber(std::string& out, const LogField& field, bool json) {
+    char digits[32];
+    std::to_chars_result result{ digits, std::errc() };
+    switch (field.type) {
+    case LogField::Type::Bool:
+        out += field.boolean ? "true" : "false";
+        return;
+    case LogField::Type::Int:
+        result = std::to_chars(digits, digits + sizeof(digits), field.integer);
+        break;
+    case LogField::Type::UInt:
+        result = std::to_chars(digits, digits + sizeof(digits), field.unsignedInteger);
+        break;
+    default:
+        if (json && !std::isfinite(field.real)) {
+            out += "null";
+            return;
+        }
+        result = std::to_chars(digits, digits + sizeof(digits), field.real);
+        break;
+    }
+    out.append(digits, result.ptr);
+}
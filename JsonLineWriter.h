@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include "LogField.h"
+
+/**
+ * @brief Serializes log records for "format": "json", one JSON object per line:
+ *     {"time":"2024-01-31 12:34:56","level":"INFO","thread":3,"message":"request served","status":200}
+ * Everything is appended to a caller-owned buffer; no json objects or
+ * temporary strings are built, so a buffer that has grown does not allocate.
+ * Text files render the same fields as key=value pairs after the message.
+ */
+struct JsonLineWriter {
+    static void appendEscaped(std::string& out, std::string_view text);
+    static void appendString(std::string& out, std::string_view text);
+    static void appendRecordStart(std::string& out, std::string_view time, std::string_view level, std::uint32_t threadId);
+    static void appendFields(std::string& out, std::initializer_list<LogField> fields);
+    static void appendKeyValues(std::string& out, std::initializer_list<LogField> fields);
+
+private:
+    static void appendNumber(std::string& out, const LogField& field, bool json);
+};
@@ -0,0 +1,395 @@
+#include "CircularLogger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+    // Heap allocations made by every thread, so a run can report allocations per message
+    std::atomic<std::uint64_t> allocationCount{ 0 };
+
+}
+
+// Every replaceable allocation form counts; the array, nothrow and sized forms
+// would otherwise reach the library's own operators and go unnoticed
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    // aligned_alloc wants a multiple of the alignment
+    auto align = static_cast<std::size_t>(alignment);
+    std::size_t rounded = (std::max<std::size_t>(size, 1) + align - 1) / align * align;
+#if defined(_MSC_VER)
+    if (void* memory = _aligned_malloc(rounded, align)) {
+#else
+    if (void* memory = std::aligned_alloc(align, rounded)) {
+#endif
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size);
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size, alignment);
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept {
+    return operator new(size, alignment, tag);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+#if defined(_MSC_VER)
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(memory, alignment);
+}
+
+void operator delete(void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    operator delete(memory, alignment);
+}
+
+void operator delete[](void* memory) noexcept {
+    operator delete(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    operator delete(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    operator delete(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t alignment) noexcept {
+    operator delete(memory, alignment);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(memory, alignment);
+}
+
+void operator delete[](void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    operator delete(memory, alignment);
+}
+
+namespace {
+
+    struct Scenario {
+        const char* name;
+        json config;      // merged over the common benchmark settings
+        bool writesFiles; // false for the ring, which keeps messages in memory
+        bool structured = false; // log key/value fields instead of a formatted message
+        bool longMessages = false; // messages too long for a record's inline buffer
+        bool allocationFree = true; // checked by -a: no heap allocation once the producers are warmed up
+    };
+
+    struct Result {
+        double messagesPerSecond = 0;
+        double bytesPerSecond = 0;
+        std::uint64_t p50 = 0;
+        std::uint64_t p99 = 0;
+        std::uint64_t p999 = 0;
+        double allocationsPerMessage = 0;
+        std::uint64_t allocations = 0;
+    };
+
+    // Untimed messages every producer logs first, so that per-thread buffers, the
+    // log file and the queue slots have been set up before allocations are counted
+    constexpr std::size_t warmupMessages = 1000;
+
+    /**
+     * @brief The modes compared by the benchmark. All of them flush in 64 KiB
+     * steps so the numbers show the logging path rather than one flush per line.
+     */
+    std::vector<Scenario> scenarios() {
+        return {
+            { "sync", { {"mode", "sync"}, {"keepFileOpen", false} }, true },
+            { "persistent", { {"mode", "sync"}, {"keepFileOpen", true} }, true },
+            { "async", { {"mode", "async"}, {"queueCapacity", 65536} }, true },
+            { "ring", { {"mode", "ring"}, {"ringCapacity", 65536} }, false },
+            { "binary", { {"mode", "async"}, {"queueCapacity", 65536}, {"format", "binary"} }, true },
+            { "json", { {"mode", "sync"}, {"keepFileOpen", true}, {"format", "json"} }, true, true },
+            // Default slabs; a queue no deeper than recordSlabCount never has a long message fall back to the heap
+            { "long", { {"mode", "async"}, {"queueCapacity", 256} }, true, false, true },
+            // A new file every second and every 256 KiB, none of them deleted; rotating builds paths and opens files
+            { "rotation", { {"mode", "sync"}, {"loggingType", "second"}, {"frequency", 1},
+                {"maxEntries", 100000}, {"maxFileBytes", 256 * 1024} }, true, false, false, false },
+        };
+    }
+
+    /**
+     * @brief Prints command line usage.
+     */
+    void printUsage() {
+        std::cerr << "Usage: LogBenchmark [-t <max threads>] [-n <messages per thread>] [-s <scenario>]... [-d <work directory>] [-a]\n"
+            << "Scenarios: sync, persistent, async, ring, binary, json, long, rotation (default: all).\n"
+            << "Each scenario runs with 1, 2, 4, ... up to the maximum number of producer threads.\n"
+            << "-a fails if a scenario other than rotation allocates from the heap after its warm-up.\n";
+    }
+
+    /**
+     * @brief Returns the total size of the files in a directory tree.
+     */
+    std::uint64_t directoryBytes(const fs::path& directory) {
+        std::uint64_t total = 0;
+        std::error_code error;
+        for (const auto& entry : fs::recursive_directory_iterator(directory, error)) {
+            if (entry.is_regular_file(error)) {
+                total += entry.file_size(error);
+            }
+        }
+        return total;
+    }
+
+    /**
+     * @brief Returns the latency below which the given fraction of calls completed.
+     * @param sorted Per-call latencies in ascending order.
+     * @param fraction Percentile as a fraction, e.g. 0.99.
+     */
+    std::uint64_t percentile(const std::vector<std::uint64_t>& sorted, double fraction) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        auto index = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size()));
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    /**
+     * @brief Runs one scenario with a fixed number of producer threads.
+     * Every thread times each log() call individually; throughput covers the
+     * time until flush() returns, so queued messages are on disk when it is taken.
+     * Allocations are counted over the same span, after every thread has logged
+     * warmupMessages, those have been flushed and housekeeping is idle.
+     * @param scenario The mode to measure.
+     * @param threads Number of producer threads.
+     * @param messagesPerThread Messages logged by each thread.
+     * @param directory Empty directory for the configuration and the log files.
+     * @return The measurements.
+     */
+    Result run(const Scenario& scenario, int threads, std::size_t messagesPerThread, const fs::path& directory) {
+        json config = {
+            {"configReloadMs", 0},
+            {"flushPolicy", "bytes"},
+            {"flushBytes", 65536},
+            {"loggingType", "hour"},
+            {"frequency", 1},
+            {"ringCrashDump", false},
+        };
+        config.update(scenario.config);
+        fs::create_directories(directory);
+        std::ofstream(directory / "config.json") << config.dump(4);
+
+        // The logger writes its files below the working directory
+        fs::path previousDirectory = fs::current_path();
+        fs::current_path(directory);
+
+        std::vector<std::vector<std::uint64_t>> latencies(threads, std::vector<std::uint64_t>(messagesPerThread));
+        Result result;
+        {
+            CircularLogger logger("config.json");
+            std::atomic<int> ready{ 0 };
+            std::atomic<bool> start{ false };
+            std::vector<std::thread> producers;
+            const std::string padding(300, 'x');
+            for (int t = 0; t < threads; ++t) {
+                producers.emplace_back([&, t] {
+                    auto& own = latencies[t];
+                    auto logOne = [&](std::size_t i) {
+                        if (scenario.structured) {
+                            logger.log(LogLevel::Info, "benchmark message", { { "index", i }, { "thread", t }, { "value", 3.25 } });
+                        }
+                        else if (scenario.longMessages) {
+                            logger.log("benchmark message {} from thread {} value {} {}", i, t, 3.25, padding);
+                        }
+                        else {
+                            logger.log("benchmark message {} from thread {} value {}", i, t, 3.25);
+                        }
+                    };
+                    for (std::size_t i = 0; i < warmupMessages; ++i) {
+                        logOne(i);
+                    }
+                    ready.fetch_add(1);
+                    while (!start.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    for (std::size_t i = 0; i < messagesPerThread; ++i) {
+                        auto before = std::chrono::steady_clock::now();
+                        logOne(i);
+                        auto after = std::chrono::steady_clock::now();
+                        own[i] = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count());
+                    }
+                });
+            }
+            while (ready.load() < threads) {
+                std::this_thread::yield();
+            }
+            logger.flush();
+            // State files written since the logger opened are saved on the housekeeping thread
+            while (logger.housekeepingQueueDepth() > 0) {
+                std::this_thread::yield();
+            }
+
+            std::uint64_t allocationsBefore = allocationCount.load();
+            auto begin = std::chrono::steady_clock::now();
+            start.store(true, std::memory_order_release);
+            for (auto& producer : producers) {
+                producer.join();
+            }
+            logger.flush();
+            auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            std::uint64_t allocations = allocationCount.load() - allocationsBefore;
+
+            double messages = static_cast<double>(messagesPerThread) * threads;
+            result.messagesPerSecond = messages / elapsed;
+            result.allocations = allocations;
+            result.allocationsPerMessage = static_cast<double>(allocations) / messages;
+            if (scenario.writesFiles) {
+                result.bytesPerSecond = static_cast<double>(directoryBytes("Logs")) / elapsed;
+            }
+        }
+        fs::current_path(previousDirectory);
+
+        std::vector<std::uint64_t> merged;
+        merged.reserve(messagesPerThread * threads);
+        for (const auto& own : latencies) {
+            merged.insert(merged.end(), own.begin(), own.end());
+        }
+        std::sort(merged.begin(), merged.end());
+        result.p50 = percentile(merged, 0.50);
+        result.p99 = percentile(merged, 0.99);
+        result.p999 = percentile(merged, 0.999);
+        return result;
+    }
+
+}
+
+/**
+ * @brief Entry point of the logging hot path benchmark.
+ */
+int main(int argc, char* argv[]) {
+    int maxThreads = 4;
+    std::size_t messagesPerThread = 200000;
+    std::vector<std::string> selected;
+    fs::path workDirectory = "LogBenchmark.work";
+    bool checkAllocations = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "-t" && i + 1 < argc) {
+            maxThreads = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (argument == "-n" && i + 1 < argc) {
+            messagesPerThread = static_cast<std::size_t>(std::max(1ll, std::atoll(argv[++i])));
+        }
+        else if (argument == "-s" && i + 1 < argc) {
+            selected.push_back(argv[++i]);
+        }
+        else if (argument == "-d" && i + 1 < argc) {
+            workDirectory = argv[++i];
+        }
+        else if (argument == "-a") {
+            checkAllocations = true;
+        }
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    workDirectory = fs::absolute(workDirectory);
+    int exitCode = 0;
+    std::printf("%-11s %7s %12s %9s %9s %9s %9s %11s\n",
+        "scenario", "threads", "msgs/s", "MB/s", "p50 ns", "p99 ns", "p99.9 ns", "allocs/msg");
+    for (const auto& scenario : scenarios()) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), scenario.name) == selected.end()) {
+            continue;
+        }
+        for (int threads = 1; ; threads = std::min(threads * 2, maxThreads)) {
+            fs::path directory = workDirectory / (std::string(scenario.name) + "-" + std::to_string(threads));
+            fs::remove_all(directory);
+            Result result = run(scenario, threads, messagesPerThread, directory);
+            if (scenario.writesFiles) {
+                std::printf("%-11s %7d %12.0f %9.1f %9llu %9llu %9llu %11.2f\n", scenario.name, threads,
+                    result.messagesPerSecond, result.bytesPerSecond / (1024 * 1024),
+                    static_cast<unsigned long long>(result.p50), static_cast<unsigned long long>(result.p99),
+                    static_cast<unsigned long long>(result.p999), result.allocationsPerMessage);
+            }
+            else {
+                std::printf("%-11s %7d %12.0f %9s %9llu %9llu %9llu %11.2f\n", scenario.name, threads,
+                    result.messagesPerSecond, "-",
+                    static_cast<unsigned long long>(result.p50), static_cast<unsigned long long>(result.p99),
+                    static_cast<unsigned long long>(result.p999), result.allocationsPerMessage);
+            }
+            std::fflush(stdout);
+            if (checkAllocations && scenario.allocationFree && result.allocations > 0) {
+                std::fprintf(stderr, "%s with %d threads: %llu heap allocations after warm-up\n", scenario.name, threads,
+                    static_cast<unsigned long long>(result.allocations));
+                exitCode = 1;
+            }
+            if (threads == maxThreads) {
+                break;
+            }
+        }
+    }
+    return exitCode;
+}
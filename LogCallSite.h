@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#include "LogLevel.h"
+
+/**
+ * @brief Rate limit state of one logging statement. The CLOG_*_LIMITED macros
+ * keep one as a static at every call site, so a statement that fires
+ * thousands of times a second only competes with itself.
+ * The limit is a token bucket in its single-counter form: the site remembers
+ * when its bucket is next full, a message is admitted while that time is less
+ * than a burst ahead of now, and each admitted message moves it one interval
+ * further. Suppressed messages are counted until the next admitted one
+ * reports them, or until the logger that suppressed them reports them on
+ * flush() or destruction.
+ * A site is not tied to a logger; whichever logger admits a message through
+ * it updates the same bucket. A suppressed run belongs to the logger that
+ * suppressed its first message.
+ */
+class LogCallSite {
+public:
+    constexpr LogCallSite(const char* file, int line) : file(file), line(line) {}
+
+    const char* const file;  // of the statement, for reports that are not next to its messages
+    const int line;
+
+    /**
+     * @brief Takes a token for one message.
+     * @param perSecond Sustained messages per second, > 0.
+     * @param burst Messages allowed back to back after a quiet period, >= 1.
+     * @param nowNanos Current time on a monotonic clock.
+     * @return false if the message is suppressed.
+     */
+    bool tryAcquire(double perSecond, int burst, std::int64_t nowNanos) {
+        // A tiny rate or a huge burst must not overflow the interval, the tolerance or nextDue
+        auto interval = static_cast<std::int64_t>(std::min(static_cast<double>(maxSpanNanos), 1e9 / perSecond));
+        std::int64_t tolerance = 0;
+        if (burst > 1) {
+            tolerance = interval > maxSpanNanos / (burst - 1) ? maxSpanNanos : interval * (burst - 1);
+        }
+        std::int64_t due = nextDue.load(std::memory_order_relaxed);
+        do {
+            if (due - nowNanos > tolerance) {
+                return false;
+            }
+        } while (!nextDue.compare_exchange_weak(due, std::max(due, nowNanos) + interval, std::memory_order_relaxed));
+        return true;
+    }
+
+    /**
+     * @brief Counts a suppressed message.
+     * @param logger The logger that suppressed it.
+     * @param level The message's level.
+     * @return true for the first message of a run, which makes logger its owner;
+     * the logger then has to remember the site to report the run.
+     */
+    bool countSuppressed(const void* logger, LogLevel level) {
+        if (suppressed.fetch_add(1, std::memory_order_relaxed) != 0) {
+            return false;
+        }
+        owner.store(logger, std::memory_order_relaxed);
+        runLevel.store(level, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Returns and resets the number of messages suppressed since the last
+     * call, if the run belongs to logger.
+     */
+    std::uint64_t takeSuppressed(const void* logger) {
+        if (suppressed.load(std::memory_order_relaxed) == 0 || owner.load(std::memory_order_relaxed) != logger) {
+            return 0;
+        }
+        return suppressed.exchange(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief The level of the message that started the current suppressed run.
+     */
+    LogLevel suppressedLevel() const {
+        return runLevel.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Bound of the interval and the tolerance, about 73 years: a power of two, so exact as a
+    // double, and a quarter of the int64 range, so nextDue never overflows
+    static constexpr std::int64_t maxSpanNanos = std::int64_t{ 1 } << 61;
+
+    std::atomic<std::int64_t> nextDue{ 0 };       // time the bucket would be full again, in nanoseconds
+    std::atomic<std::uint64_t> suppressed{ 0 };
+    std::atomic<const void*> owner{ nullptr };   // logger of the current suppressed run
+    std::atomic<LogLevel> runLevel{ LogLevel::Info };
+};
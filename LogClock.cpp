@@ -0,0 +1,301 @@
+#include "LogClock.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CIRCULARLOGGER_HAS_TSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define CIRCULARLOGGER_HAS_TSC 1
+#else
+#define CIRCULARLOGGER_HAS_TSC 0
+#endif
+
+namespace {
+
+#if CIRCULARLOGGER_HAS_TSC
+
+    std::int64_t systemNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief Returns true if the CPU reports an invariant TSC, one that ticks at
+     * a constant rate in every power state and is synchronized across cores.
+     */
+    bool hasInvariantTsc() {
+#ifdef _MSC_VER
+        int registers[4];
+        __cpuid(registers, 0x80000000);
+        if (static_cast<unsigned>(registers[0]) < 0x80000007u) {
+            return false;
+        }
+        __cpuid(registers, 0x80000007);
+        return (registers[3] & (1 << 8)) != 0;
+#else
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+        return (edx & (1u << 8)) != 0;
+#endif
+    }
+
+    /**
+     * @brief Multiplies ticks by a 32.32 fixed-point factor without overflowing.
+     * The factor is below 2^32 for any TSC faster than 1 GHz.
+     */
+    std::uint64_t scaleTicks(std::uint64_t ticks, std::uint64_t scale) {
+        return (ticks >> 32) * scale + (((ticks & 0xffffffffu) * scale) >> 32);
+    }
+
+    /**
+     * @brief Returns nanos / ticks as a 32.32 fixed-point factor; computed in
+     * floating point so a long interval cannot overflow.
+     */
+    std::uint64_t fixedRatio(std::int64_t nanos, std::uint64_t ticks) {
+        return static_cast<std::uint64_t>(static_cast<double>(nanos) / static_cast<double>(ticks) * 4294967296.0);
+    }
+
+    /**
+     * @brief Converts TSC readings to wall clock time. A background thread
+     * compares the two clocks every second and publishes a new base and rate
+     * through a sequence lock, so now() never blocks. Small drift is slewed
+     * out over the next second to keep timestamps from stepping backwards;
+     * a wall clock jump of more than a millisecond is followed immediately.
+     */
+    class TscCalibrator {
+    public:
+        static TscCalibrator& instance() {
+            static TscCalibrator calibrator;
+            return calibrator;
+        }
+
+        /**
+         * @brief Returns the current time, or false until the first calibration is done.
+         */
+        bool now(std::int64_t& nanos) const {
+            return estimate(__rdtsc(), nanos);
+        }
+
+    private:
+        static constexpr std::int64_t intervalNanos = 1000000000;
+        static constexpr std::int64_t maxSlewNanos = 1000000;
+
+        std::atomic<std::uint32_t> sequence{ 0 };
+        std::atomic<std::uint64_t> baseTicks{ 0 };
+        std::atomic<std::int64_t> baseNanos{ 0 };
+        std::atomic<std::uint64_t> scale{ 0 };  // nanoseconds per tick, 32.32 fixed point; 0 until calibrated
+
+        std::mutex stopMutex;
+        std::condition_variable stopSignal;
+        bool stopRequested = false;
+        std::thread worker;
+
+        TscCalibrator() {
+            worker = std::thread(&TscCalibrator::run, this);
+        }
+
+        ~TscCalibrator() {
+            {
+                std::lock_guard<std::mutex> lock(stopMutex);
+                stopRequested = true;
+            }
+            stopSignal.notify_one();
+            worker.join();
+        }
+
+        bool estimate(std::uint64_t ticks, std::int64_t& nanos) const {
+            std::uint32_t before;
+            std::uint64_t base;
+            std::int64_t baseTime;
+            std::uint64_t factor;
+            do {
+                before = sequence.load(std::memory_order_acquire);
+                base = baseTicks.load(std::memory_order_relaxed);
+                baseTime = baseNanos.load(std::memory_order_relaxed);
+                factor = scale.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+            } while ((before & 1) != 0 || sequence.load(std::memory_order_relaxed) != before);
+            if (factor == 0) {
+                return false;
+            }
+            // Another core's counter may lag the base slightly
+            nanos = ticks >= base ? baseTime + static_cast<std::int64_t>(scaleTicks(ticks - base, factor))
+                : baseTime - static_cast<std::int64_t>(scaleTicks(base - ticks, factor));
+            return true;
+        }
+
+        void publish(std::uint64_t ticks, std::int64_t nanos, std::uint64_t factor) {
+            std::uint32_t current = sequence.load(std::memory_order_relaxed);
+            sequence.store(current + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            baseTicks.store(ticks, std::memory_order_relaxed);
+            baseNanos.store(nanos, std::memory_order_relaxed);
+            scale.store(factor, std::memory_order_relaxed);
+            sequence.store(current + 2, std::memory_order_release);
+        }
+
+        // Reads both clocks as close together as possible: the tightest of a few tries
+        static void sample(std::uint64_t& ticks, std::int64_t& nanos) {
+            std::uint64_t bestGap = UINT64_MAX;
+            for (int attempt = 0; attempt < 5; ++attempt) {
+                std::uint64_t before = __rdtsc();
+                std::int64_t time = systemNanos();
+                std::uint64_t after = __rdtsc();
+                if (after - before < bestGap) {
+                    bestGap = after - before;
+                    ticks = before + (after - before) / 2;
+                    nanos = time;
+                }
+            }
+        }
+
+        // Waits for the given time; returns false if the calibrator is stopping
+        bool sleepFor(std::chrono::nanoseconds duration) {
+            std::unique_lock<std::mutex> lock(stopMutex);
+            return !stopSignal.wait_for(lock, duration, [this] { return stopRequested; });
+        }
+
+        void run() {
+            std::uint64_t previousTicks = 0;
+            std::int64_t previousNanos = 0;
+            sample(previousTicks, previousNanos);
+            // A short first window makes the clock usable quickly; later ones refine it
+            if (!sleepFor(std::chrono::milliseconds(10))) {
+                return;
+            }
+            std::uint64_t ticks = 0;
+            std::int64_t nanos = 0;
+            sample(ticks, nanos);
+            if (ticks <= previousTicks || nanos <= previousNanos) {
+                return;  // counter not usable; now() keeps falling back to the system clock
+            }
+            publish(ticks, nanos, fixedRatio(nanos - previousNanos, ticks - previousTicks));
+            previousTicks = ticks;
+            previousNanos = nanos;
+
+            while (sleepFor(std::chrono::nanoseconds(intervalNanos))) {
+                sample(ticks, nanos);
+                if (ticks <= previousTicks || nanos <= previousNanos) {
+                    publish(ticks, nanos, scale.load(std::memory_order_relaxed));
+                }
+                else {
+                    std::uint64_t measured = fixedRatio(nanos - previousNanos, ticks - previousTicks);
+                    std::int64_t estimated = nanos;
+                    estimate(ticks, estimated);
+                    std::int64_t error = nanos - estimated;
+                    if (error > maxSlewNanos || error < -maxSlewNanos || measured == 0) {
+                        publish(ticks, nanos, measured);
+                    }
+                    else {
+                        // Continue from the current estimate at a rate that meets the wall clock in one interval
+                        double intervalTicks = static_cast<double>(intervalNanos) * 4294967296.0 / static_cast<double>(measured);
+                        publish(ticks, estimated, fixedRatio(intervalNanos + error, static_cast<std::uint64_t>(intervalTicks)));
+                    }
+                }
+                previousTicks = ticks;
+                previousNanos = nanos;
+            }
+        }
+    };
+
+#endif
+
+}
+
+/**
+ * @brief Constructor for a built-in clock. An unavailable TSC falls back to the system clock.
+ * @param source The clock to read.
+ */
+LogClock::LogClock(ClockSource source) {
+    switch (source) {
+    case ClockSource::Coarse:
+        nowFunction = &LogClock::coarseNow;
+        break;
+    case ClockSource::Tsc:
+        nowFunction = tscAvailable() ? &LogClock::tscNow : &LogClock::systemNow;
+        break;
+    default:
+        nowFunction = &LogClock::systemNow;
+        break;
+    }
+}
+
+/**
+ * @brief Constructor for a user-supplied clock.
+ * @param custom Called for every message; must be safe to call from any thread.
+ */
+LogClock::LogClock(NowFunction custom) : nowFunction(custom) {
+}
+
+/**
+ * @brief Reads std::chrono::system_clock.
+ */
+std::chrono::system_clock::time_point LogClock::systemNow() {
+    return std::chrono::system_clock::now();
+}
+
+/**
+ * @brief Reads the wall clock at scheduler tick resolution, which skips the
+ * hardware counter read; falls back to the system clock where no such clock exists.
+ */
+std::chrono::system_clock::time_point LogClock::coarseNow() {
+#if defined(_WIN32)
+    FILETIME fileTime;
+    GetSystemTimeAsFileTime(&fileTime);
+    // 100 ns intervals since 1601-01-01
+    std::uint64_t intervals = (static_cast<std::uint64_t>(fileTime.dwHighDateTime) << 32) | fileTime.dwLowDateTime;
+    constexpr std::uint64_t unixEpoch = 116444736000000000ull;
+    auto sinceEpoch = std::chrono::duration<std::int64_t, std::ratio<1, 10000000>>(static_cast<std::int64_t>(intervals - unixEpoch));
+    return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(sinceEpoch));
+#elif defined(CLOCK_REALTIME_COARSE)
+    timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    auto sinceEpoch = std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+    return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(sinceEpoch));
+#else
+    return std::chrono::system_clock::now();
+#endif
+}
+
+/**
+ * @brief Reads the calibrated TSC clock; the system clock is used until the
+ * first calibration, about 10 ms after the first call.
+ */
+std::chrono::system_clock::time_point LogClock::tscNow() {
+#if CIRCULARLOGGER_HAS_TSC
+    std::int64_t nanos;
+    if (TscCalibrator::instance().now(nanos)) {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanos)));
+    }
+#endif
+    return std::chrono::system_clock::now();
+}
+
+/**
+ * @brief Returns true if this CPU has a TSC that can serve as a clock.
+ */
+bool LogClock::tscAvailable() {
+#if CIRCULARLOGGER_HAS_TSC
+    static const bool available = hasInvariantTsc();
+    return available;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+
+enum class ClockSource {
+    System,  // std::chrono::system_clock
+    Coarse,  // tick-resolution wall clock (CLOCK_REALTIME_COARSE, GetSystemTimeAsFileTime)
+    Tsc      // time stamp counter calibrated against the wall clock
+};
+
+/**
+ * @brief Source of the timestamps written with each message.
+ * The logger reads the clock once per message, so the choice trades
+ * resolution for cost: the coarse clock is a plain memory read on Linux but
+ * only advances every few milliseconds; the TSC clock costs one rdtsc and is
+ * kept in step with the wall clock by a background thread that recalibrates
+ * it every second. A custom function can be plugged in, for instance to
+ * replay recorded times.
+ */
+class LogClock {
+public:
+    using NowFunction = std::chrono::system_clock::time_point (*)();
+
+    explicit LogClock(ClockSource source = ClockSource::System);
+    explicit LogClock(NowFunction custom);
+
+    std::chrono::system_clock::time_point now() const { return nowFunction(); }
+
+    static std::chrono::system_clock::time_point systemNow();
+    static std::chrono::system_clock::time_point coarseNow();
+    static std::chrono::system_clock::time_point tscNow();
+    static bool tscAvailable();
+
+private:
+    NowFunction nowFunction;
+};
@@ -0,0 +1,166 @@
+#include "ArgumentCodec.h"
+#include "BinaryLogFormat.h"
+#include "LogLevel.h"
+#include "TimestampCache.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+    /**
+     * @brief Prints command line usage.
+     */
+    void printUsage() {
+        std::cerr << "Usage: LogDecoder <binary log file> [-p s|ms|us] [-o <output file>]\n"
+            << "Converts a log written with \"format\": \"binary\" to the text layout.\n";
+    }
+
+    /**
+     * @brief Decodes one binary log into text lines.
+     * @param data Contents of the binary log file.
+     * @param precision Precision of the printed timestamps.
+     * @param out Stream that receives the decoded lines.
+     * @return True if the whole file was decoded, false if it is not a binary
+     * log or its last record is incomplete.
+     */
+    bool decode(const std::string& data, TimestampPrecision precision, std::ostream& out) {
+        if (data.size() < sizeof(BinaryLogFormat::magic)
+            || std::memcmp(data.data(), BinaryLogFormat::magic, sizeof(BinaryLogFormat::magic)) != 0) {
+            std::cerr << "Not a binary log file\n";
+            return false;
+        }
+
+        std::unordered_map<std::uint32_t, std::string> formats;
+        TimestampCache timestamps;
+        std::string line;
+        std::size_t offset = sizeof(BinaryLogFormat::magic);
+        while (offset < data.size()) {
+            auto type = static_cast<std::uint8_t>(data[offset]);
+            if (type == BinaryLogFormat::FormatDefinition) {
+                BinaryLogFormat::FormatHeader header;
+                if (data.size() - offset < sizeof(header)) {
+                    break;
+                }
+                std::memcpy(&header, data.data() + offset, sizeof(header));
+                offset += sizeof(header);
+                if (data.size() - offset < header.length) {
+                    break;
+                }
+                formats[header.formatId] = data.substr(offset, header.length);
+                offset += header.length;
+            }
+            else if (type == BinaryLogFormat::Message) {
+                BinaryLogFormat::MessageHeader header;
+                if (data.size() - offset < sizeof(header)) {
+                    break;
+                }
+                std::memcpy(&header, data.data() + offset, sizeof(header));
+                offset += sizeof(header);
+                if (data.size() - offset < header.payloadLength) {
+                    break;
+                }
+                std::string_view payload(data.data() + offset, header.payloadLength);
+                offset += header.payloadLength;
+
+                auto time = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                    std::chrono::microseconds(header.timeMicros)));
+                line.assign(timestamps.format(time, precision));
+                line += ' ';
+                line += logLevelName(static_cast<LogLevel>(header.level));
+                line += " - ";
+                if (header.formatId == 0) {
+                    line += payload;
+                }
+                else {
+                    auto format = formats.find(header.formatId);
+                    if (format == formats.end()) {
+                        line += "<undefined format id " + std::to_string(header.formatId) + ">";
+                    }
+                    else {
+                        ArgumentCodec::formatTagged(line, format->second,
+                            reinterpret_cast<const std::byte*>(payload.data()), payload.size());
+                    }
+                }
+                line += '\n';
+                out << line;
+            }
+            else {
+                std::cerr << "Unknown record type " << static_cast<int>(type) << " at offset " << offset << '\n';
+                return false;
+            }
+        }
+
+        if (offset < data.size()) {
+            // A crash or power loss can leave the last record half written
+            std::cerr << "Ignoring incomplete record at offset " << offset << '\n';
+            return false;
+        }
+        return true;
+    }
+
+}
+
+/**
+ * @brief Entry point of the offline decoder for binary log files.
+ */
+int main(int argc, char* argv[]) {
+    std::string inputPath;
+    std::string outputPath;
+    TimestampPrecision precision = TimestampPrecision::Seconds;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "-p" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "ms") {
+                precision = TimestampPrecision::Milliseconds;
+            }
+            else if (value == "us") {
+                precision = TimestampPrecision::Microseconds;
+            }
+            else if (value != "s") {
+                printUsage();
+                return 2;
+            }
+        }
+        else if (argument == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        }
+        else if (inputPath.empty() && argument[0] != '-') {
+            inputPath = argument;
+        }
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (inputPath.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    std::ifstream input(inputPath, std::ios::binary);
+    if (!input) {
+        std::cerr << "Cannot open " << inputPath << '\n';
+        return 1;
+    }
+    std::string data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    bool complete;
+    if (outputPath.empty()) {
+        complete = decode(data, precision, std::cout);
+    }
+    else {
+        std::ofstream output(outputPath, std::ios::binary);
+        if (!output) {
+            std::cerr << "Cannot open " << outputPath << '\n';
+            return 1;
+        }
+        complete = decode(data, precision, output);
+    }
+    return complete ? 0 : 1;
+}
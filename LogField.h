@@ -0,0 +1,49 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief One key/value pair of a structured log record:
+ *     logger.log(LogLevel::Info, "request served", { { "status", 200 }, { "path", path }, { "ms", 1.25 } });
+ * A field only refers to its key and string value, so building one never
+ * allocates; both must stay valid until the log() call returns.
+ */
+struct LogField {
+    enum class Type : std::uint8_t {
+        Bool,
+        Int,
+        UInt,
+        Double,
+        String
+    };
+
+    std::string_view key;
+    Type type;
+    std::string_view text;  // String fields only
+    union {
+        bool boolean;
+        std::int64_t integer;
+        std::uint64_t unsignedInteger;
+        double real;
+    };
+
+    LogField(std::string_view key, bool value) : key(key), type(Type::Bool), boolean(value) {}
+
+    template <std::signed_integral T>
+        requires (!std::same_as<T, bool>)
+    LogField(std::string_view key, T value) : key(key), type(Type::Int), integer(value) {}
+
+    template <std::unsigned_integral T>
+        requires (!std::same_as<T, bool>)
+    LogField(std::string_view key, T value) : key(key), type(Type::UInt), unsignedInteger(value) {}
+
+    template <std::floating_point T>
+    LogField(std::string_view key, T value) : key(key), type(Type::Double), real(static_cast<double>(value)) {}
+
+    LogField(std::string_view key, std::string_view value) : key(key), type(Type::String), text(value), integer(0) {}
+    LogField(std::string_view key, const char* value) : LogField(key, std::string_view(value)) {}
+    LogField(std::string_view key, const std::string& value) : LogField(key, std::string_view(value)) {}
+};
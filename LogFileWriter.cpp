@@ -0,0 +1,832 @@
+#include "LogFileWriter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Creates the writer for the configured output mode.
+ * @param options Output mode and its settings.
+ * @return A closed writer.
+ */
+std::unique_ptr<LogFileWriter> LogFileWriter::create(const LogFileWriterOptions& options) {
+    switch (options.mode) {
+    case OutputMode::Mapped:
+        return std::make_unique<MappedFileWriter>(options.mappedSegmentBytes);
+    case OutputMode::Direct:
+        return std::make_unique<DirectFileWriter>(options.directBufferBytes);
+    case OutputMode::Vectored:
+        return std::make_unique<VectoredFileWriter>(options.maxBatchRecords, std::chrono::milliseconds(options.maxBatchLatencyMs));
+    default:
+        return std::make_unique<StreamFileWriter>();
+    }
+}
+
+/**
+ * @brief Turns a retired log file into the next one without creating or
+ * deleting a file: it is renamed to the new name and emptied. Only the
+ * directory entry and inode are reused; emptying the file releases its blocks,
+ * including space reserved by preallocate(), so the caller reserves it again.
+ * @param from The evicted file.
+ * @param to The name of the next log file.
+ * @return true if the file was reused; false if it could not be renamed, in
+ * which case the caller falls back to deleting it.
+ */
+bool LogFileWriter::recycle(const fs::path& from, const fs::path& to) {
+    std::error_code error;
+    if (!fs::is_regular_file(from, error) || fs::exists(to, error)) {
+        return false;
+    }
+    fs::rename(from, to, error);
+    if (error) {
+        return false;
+    }
+    fs::resize_file(to, 0, error);
+    return !error;
+}
+
+/**
+ * @brief Reserves disk space for a log file without changing its size, so
+ * appends land in blocks allocated up front in one piece and readers never see
+ * padding. Creates the file if needed. Best effort: filesystems and platforms
+ * without allocation-only reservation are left as they are.
+ * @param path The log file.
+ * @param bytes Space to reserve from the start of the file.
+ */
+void LogFileWriter::preallocate(const fs::path& path, std::uint64_t bytes) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    // Only the allocation grows; SetFileValidData would also move the end of
+    // valid data, which needs SE_MANAGE_VOLUME_NAME and exposes stale disk content
+    FILE_ALLOCATION_INFO allocation{};
+    allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(bytes);
+    SetFileInformationByHandle(file, FileAllocationInfo, &allocation, sizeof(allocation));
+    CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return;
+    }
+#ifdef FALLOC_FL_KEEP_SIZE
+    if (::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes)) != 0 && errno != EOPNOTSUPP) {
+        std::cerr << "Error preallocating " << path << ": " << std::strerror(errno) << std::endl;
+    }
+#else
+    (void)bytes; // posix_fallocate would extend the file size with zeros
+#endif
+    ::close(fd);
+#endif
+}
+
+/**
+ * @brief Appends data to a file that is not kept open: opens, writes and
+ * closes it with the system calls directly, so a message costs no stream
+ * object or stream buffer. Creates the file if needed.
+ * @param path The log file.
+ * @param data The bytes to append.
+ * @return true if everything was written.
+ */
+bool LogFileWriter::appendToFile(const fs::path& path, std::string_view data) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    DWORD written = 0;
+    bool ok = WriteFile(file, data.data(), static_cast<DWORD>(data.size()), &written, nullptr) && written == data.size();
+    CloseHandle(file);
+    return ok;
+#else
+    int fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    const char* next = data.data();
+    std::size_t remaining = data.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, next, remaining);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            break;
+        }
+        next += written;
+        remaining -= static_cast<std::size_t>(written);
+    }
+    ::close(fd);
+    return remaining == 0;
+#endif
+}
+
+/**
+ * @brief Opens the file for appending.
+ * @param path The log file to write.
+ * @return true on success.
+ */
+bool StreamFileWriter::open(const fs::path& path) {
+    stream.open(path, std::ios::app);
+    return stream.is_open();
+}
+
+/**
+ * @brief Appends data to the stream buffer.
+ * @param data The bytes to append.
+ * @return false if the stream is in a failed state.
+ */
+bool StreamFileWriter::write(std::string_view data) {
+    return static_cast<bool>(stream.write(data.data(), static_cast<std::streamsize>(data.size())));
+}
+
+/**
+ * @brief Pushes the stream buffer to the operating system.
+ */
+void StreamFileWriter::flush() {
+    stream.flush();
+}
+
+/**
+ * @brief Flushes and closes the file.
+ */
+void StreamFileWriter::close() {
+    stream.close();
+}
+
+/**
+ * @brief Returns true while a file is open.
+ */
+bool StreamFileWriter::isOpen() const {
+    return stream.is_open();
+}
+
+/**
+ * @brief Constructor for MappedFileWriter.
+ * @param segmentBytes Amount by which the file is preallocated and grown.
+ */
+MappedFileWriter::MappedFileWriter(std::uint64_t segmentBytes) : segmentBytes(segmentBytes > 0 ? segmentBytes : 1) {
+}
+
+/**
+ * @brief Destructor. Truncates and closes the file if it is still open.
+ */
+MappedFileWriter::~MappedFileWriter() {
+    close();
+}
+
+/**
+ * @brief Opens (or creates) the file and maps the first segment after its current end.
+ * @param path The log file to write.
+ * @return true on success.
+ */
+bool MappedFileWriter::open(const fs::path& path) {
+    close();
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    fileHandle = handle;
+    LARGE_INTEGER size;
+    GetFileSizeEx(handle, &size);
+    usedBytes = static_cast<std::uint64_t>(size.QuadPart);
+    flushedBytes = usedBytes;
+#else
+    fileDescriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    struct stat info;
+    fstat(fileDescriptor, &info);
+    usedBytes = static_cast<std::uint64_t>(info.st_size);
+    flushedBytes = usedBytes;
+#endif
+    if (!map(usedBytes + segmentBytes)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Copies data into the mapping, growing the file by whole segments when needed.
+ * @param data The bytes to append.
+ * @return false if the file is not mapped or could not grow.
+ */
+bool MappedFileWriter::write(std::string_view data) {
+    if (view == nullptr) {
+        return false;
+    }
+    if (usedBytes + data.size() > mappedBytes) {
+        std::uint64_t size = mappedBytes;
+        while (usedBytes + data.size() > size) {
+            size += segmentBytes;
+        }
+        if (!map(size)) {
+            // Nothing is mapped any more, so every further append fails until the file is reopened
+            std::cerr << "Error growing mapped log file to " << size << " bytes" << std::endl;
+            return false;
+        }
+    }
+    std::memcpy(view + usedBytes, data.data(), data.size());
+    usedBytes += data.size();
+    return true;
+}
+
+/**
+ * @brief Starts writeback of the pages written since the last flush without
+ * waiting for it, so a flush costs the same however large the file has grown.
+ * The data is already visible to readers of the file as soon as it is copied.
+ */
+void MappedFileWriter::flush() {
+    if (view == nullptr || flushedBytes >= usedBytes) {
+        return;
+    }
+#ifdef _WIN32
+    FlushViewOfFile(view + flushedBytes, static_cast<SIZE_T>(usedBytes - flushedBytes));
+#else
+    // msync needs a page-aligned start
+    static const std::uint64_t pageBytes = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+    std::uint64_t start = flushedBytes - flushedBytes % pageBytes;
+    msync(view + start, static_cast<std::size_t>(usedBytes - start), MS_ASYNC);
+#endif
+    flushedBytes = usedBytes;
+}
+
+/**
+ * @brief Unmaps the file and truncates it to the bytes actually written.
+ */
+void MappedFileWriter::close() {
+    unmap();
+#ifdef _WIN32
+    if (fileHandle != nullptr) {
+        LARGE_INTEGER size;
+        size.QuadPart = static_cast<LONGLONG>(usedBytes);
+        SetFilePointerEx(fileHandle, size, nullptr, FILE_BEGIN);
+        SetEndOfFile(fileHandle);
+        CloseHandle(fileHandle);
+        fileHandle = nullptr;
+    }
+#else
+    if (fileDescriptor >= 0) {
+        if (ftruncate(fileDescriptor, static_cast<off_t>(usedBytes)) != 0) {
+            std::cerr << "Error truncating mapped log file" << std::endl;
+        }
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+#endif
+    usedBytes = 0;
+    flushedBytes = 0;
+}
+
+/**
+ * @brief Returns true while a file is open and mapped.
+ */
+bool MappedFileWriter::isOpen() const {
+    return view != nullptr;
+}
+
+/**
+ * @brief Extends the file to size bytes and maps all of it.
+ * @param size The new mapped length.
+ * @return true on success.
+ */
+bool MappedFileWriter::map(std::uint64_t size) {
+    unmap();
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingW(fileHandle, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFF), nullptr);
+    if (mapping == nullptr) {
+        return false;
+    }
+    void* address = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(size));
+    if (address == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+    mappingHandle = mapping;
+#else
+    if (ftruncate(fileDescriptor, static_cast<off_t>(size)) != 0) {
+        return false;
+    }
+    void* address = mmap(nullptr, static_cast<std::size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+#endif
+    view = static_cast<char*>(address);
+    mappedBytes = size;
+    return true;
+}
+
+/**
+ * @brief Releases the current mapping, if any.
+ */
+void MappedFileWriter::unmap() {
+    if (view == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(view);
+    CloseHandle(mappingHandle);
+    mappingHandle = nullptr;
+#else
+    munmap(view, static_cast<std::size_t>(mappedBytes));
+#endif
+    view = nullptr;
+    mappedBytes = 0;
+}
+
+/**
+ * @brief Constructor for VectoredFileWriter.
+ * @param maxBatchRecords Number of appends collected before they are written.
+ * @param maxBatchLatency Longest time an append is held back, checked on the next append.
+ */
+VectoredFileWriter::VectoredFileWriter(std::size_t maxBatchRecords, std::chrono::milliseconds maxBatchLatency)
+    : maxBatchRecords(maxBatchRecords > 0 ? maxBatchRecords : 1), maxBatchLatency(maxBatchLatency) {
+}
+
+/**
+ * @brief Destructor. Writes the pending batch and closes the file.
+ */
+VectoredFileWriter::~VectoredFileWriter() {
+    close();
+}
+
+/**
+ * @brief Opens (or creates) the file for appending.
+ * @param path The log file to write.
+ * @return true on success.
+ */
+bool VectoredFileWriter::open(const fs::path& path) {
+    close();
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_DELETE,
+        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    fileHandle = handle;
+#else
+    fileDescriptor = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief Copies data into the current batch and writes the batch if it is due.
+ * @param data The bytes to append.
+ * @return false if no file is open; a batch that fails later is reported by takeLostBytes().
+ */
+bool VectoredFileWriter::write(std::string_view data) {
+    if (!isOpen()) {
+        return false;
+    }
+    Chunk* chunk = activeChunks > 0 ? &chunks[activeChunks - 1] : nullptr;
+    if (chunk == nullptr || chunk->capacity - chunk->used < data.size()) {
+        if (activeChunks == maxChunks) {
+            writeBatch();
+        }
+        chunk = &startChunk(data.size());
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (batchRecords == 0) {
+        batchStart = now;
+    }
+    std::memcpy(chunk->data.get() + chunk->used, data.data(), data.size());
+    chunk->used += data.size();
+    ++batchRecords;
+    if (batchRecords >= maxBatchRecords || now - batchStart >= maxBatchLatency) {
+        writeBatch();
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the pending batch to the operating system.
+ */
+void VectoredFileWriter::flush() {
+    writeBatch();
+}
+
+/**
+ * @brief Writes the pending batch and closes the file.
+ */
+void VectoredFileWriter::close() {
+    if (!isOpen()) {
+        return;
+    }
+    writeBatch();
+#ifdef _WIN32
+    CloseHandle(fileHandle);
+    fileHandle = nullptr;
+#else
+    ::close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+}
+
+/**
+ * @brief Returns true while a file is open.
+ */
+bool VectoredFileWriter::isOpen() const {
+#ifdef _WIN32
+    return fileHandle != nullptr;
+#else
+    return fileDescriptor >= 0;
+#endif
+}
+
+/**
+ * @brief Returns and resets the number of appended bytes dropped with failed batches.
+ */
+std::uint64_t VectoredFileWriter::takeLostBytes() {
+    return std::exchange(lostBytes, 0);
+}
+
+/**
+ * @brief Makes the next chunk of the batch current, reusing an earlier allocation when it is large enough.
+ * @param minimumBytes Size of the append that has to fit; larger than chunkBytes only for very long lines.
+ * @return The empty chunk.
+ */
+VectoredFileWriter::Chunk& VectoredFileWriter::startChunk(std::size_t minimumBytes) {
+    if (activeChunks == chunks.size()) {
+        chunks.emplace_back();
+    }
+    Chunk& chunk = chunks[activeChunks++];
+    if (chunk.capacity < minimumBytes || chunk.capacity == 0) {
+        chunk.capacity = minimumBytes > chunkBytes ? minimumBytes : chunkBytes;
+        chunk.data = std::make_unique<char[]>(chunk.capacity);
+    }
+    chunk.used = 0;
+    return chunk;
+}
+
+/**
+ * @brief Writes every filled chunk in one call, resuming after partial writes.
+ * On an error the rest of the batch is dropped and added to lostBytes.
+ * @return false if the batch was not written completely.
+ */
+bool VectoredFileWriter::writeBatch() {
+    if (activeChunks == 0) {
+        return true;
+    }
+    std::uint64_t unwritten = 0;
+#ifdef _WIN32
+    for (std::size_t i = 0; i < activeChunks; ++i) {
+        const char* data = chunks[i].data.get();
+        std::size_t remaining = chunks[i].used;
+        while (remaining > 0 && unwritten == 0) {
+            DWORD written = 0;
+            if (!WriteFile(fileHandle, data, static_cast<DWORD>(remaining), &written, nullptr)) {
+                std::cerr << "Error writing log file" << std::endl;
+                break;
+            }
+            data += written;
+            remaining -= written;
+        }
+        unwritten += remaining;
+    }
+#else
+    iovec vectors[maxChunks];
+    for (std::size_t i = 0; i < activeChunks; ++i) {
+        vectors[i].iov_base = chunks[i].data.get();
+        vectors[i].iov_len = chunks[i].used;
+    }
+    iovec* next = vectors;
+    int count = static_cast<int>(activeChunks);
+    while (count > 0) {
+        ssize_t written = ::writev(fileDescriptor, next, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error writing log file: " << std::strerror(errno) << std::endl;
+            for (int i = 0; i < count; ++i) {
+                unwritten += next[i].iov_len;
+            }
+            break;
+        }
+        std::size_t remaining = static_cast<std::size_t>(written);
+        while (count > 0 && remaining >= next->iov_len) {
+            remaining -= next->iov_len;
+            ++next;
+            --count;
+        }
+        if (count > 0) {
+            next->iov_base = static_cast<char*>(next->iov_base) + remaining;
+            next->iov_len -= remaining;
+        }
+    }
+#endif
+    activeChunks = 0;
+    batchRecords = 0;
+    lostBytes += unwritten;
+    return unwritten == 0;
+}
+
+/**
+ * @brief Constructor for DirectFileWriter. Allocates both staging buffers and
+ * starts the I/O thread.
+ * @param bufferBytes Size of each staging buffer, rounded up to whole blocks.
+ */
+DirectFileWriter::DirectFileWriter(std::size_t bufferBytes)
+    : bufferBytes(bufferBytes < blockBytes ? blockBytes : (bufferBytes + blockBytes - 1) / blockBytes * blockBytes) {
+    for (AlignedBuffer& buffer : buffers) {
+        buffer.reset(new (std::align_val_t(blockBytes)) char[this->bufferBytes]);
+    }
+    ioThread = std::thread(&DirectFileWriter::ioLoop, this);
+}
+
+/**
+ * @brief Destructor. Writes the tail, closes the file and stops the I/O thread.
+ */
+DirectFileWriter::~DirectFileWriter() {
+    close();
+    {
+        std::lock_guard<std::mutex> lock(ioMutex);
+        stopRequested = true;
+    }
+    ioWake.notify_one();
+    ioThread.join();
+}
+
+/**
+ * @brief Opens (or creates) the file and loads its last partial block, since
+ * unbuffered writes must start at a block boundary.
+ * Falls back to buffered I/O with a warning on filesystems without O_DIRECT.
+ * @param path The log file to write.
+ * @return true on success.
+ */
+bool DirectFileWriter::open(const fs::path& path) {
+    close();
+    std::uint64_t size;
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    fileHandle = handle;
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(handle, &fileSize);
+    size = static_cast<std::uint64_t>(fileSize.QuadPart);
+#else
+    fileDescriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_DIRECT, 0644);
+    if (fileDescriptor < 0 && errno == EINVAL) {
+        std::cerr << "O_DIRECT is not supported for " << path << ", writing through the page cache" << std::endl;
+        fileDescriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    }
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    struct stat info;
+    fstat(fileDescriptor, &info);
+    size = static_cast<std::uint64_t>(info.st_size);
+#endif
+    activeBuffer = 0;
+    bufferOffset = size / blockBytes * blockBytes;
+    fill = static_cast<std::size_t>(size - bufferOffset);
+    if (fill > 0 && !readAt(buffers[activeBuffer].get(), blockBytes, bufferOffset)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Copies data into the active staging buffer, handing each full buffer
+ * to the I/O thread.
+ * @param data The bytes to append.
+ * @return false if no file is open; a buffer the I/O thread fails to write is reported by takeLostBytes().
+ */
+bool DirectFileWriter::write(std::string_view data) {
+    if (!isOpen()) {
+        return false;
+    }
+    while (!data.empty()) {
+        std::size_t chunk = data.size() < bufferBytes - fill ? data.size() : bufferBytes - fill;
+        std::memcpy(buffers[activeBuffer].get() + fill, data.data(), chunk);
+        fill += chunk;
+        data.remove_prefix(chunk);
+        if (fill == bufferBytes) {
+            waitForIo();
+            submit(buffers[activeBuffer].get(), bufferOffset);
+            bufferOffset += bufferBytes;
+            activeBuffer ^= 1;
+            fill = 0;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Writes everything appended so far, including the padded partial last
+ * block, and trims the padding off the end of the file.
+ * The partial block stays in the staging buffer and is rewritten as it fills.
+ */
+void DirectFileWriter::flush() {
+    if (!isOpen()) {
+        return;
+    }
+    writeTail();
+}
+
+/**
+ * @brief Writes the tail and closes the file at its exact length.
+ */
+void DirectFileWriter::close() {
+    if (!isOpen()) {
+        return;
+    }
+    if (!writeTail()) {
+        // A failed flush is retried by the next one, but nothing follows the close
+        lostBytes += fill;
+    }
+#ifdef _WIN32
+    CloseHandle(fileHandle);
+    fileHandle = nullptr;
+#else
+    ::close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+    fill = 0;
+    bufferOffset = 0;
+}
+
+/**
+ * @brief Returns and resets the number of appended bytes in buffers that could not be written.
+ */
+std::uint64_t DirectFileWriter::takeLostBytes() {
+    return std::exchange(lostBytes, 0);
+}
+
+/**
+ * @brief Returns true while a file is open.
+ */
+bool DirectFileWriter::isOpen() const {
+#ifdef _WIN32
+    return fileHandle != nullptr;
+#else
+    return fileDescriptor >= 0;
+#endif
+}
+
+/**
+ * @brief Writes the buffer in flight and the padded partial last block, then
+ * trims the padding off the end of the file.
+ * @return false if the partial block could not be written.
+ */
+bool DirectFileWriter::writeTail() {
+    waitForIo();
+    if (fill == 0) {
+        return true;
+    }
+    std::size_t padded = (fill + blockBytes - 1) / blockBytes * blockBytes;
+    char* buffer = buffers[activeBuffer].get();
+    std::memset(buffer + fill, 0, padded - fill);
+    if (!writeAt(buffer, padded, bufferOffset)) {
+        return false;
+    }
+    truncate(bufferOffset + fill);
+    return true;
+}
+
+/**
+ * @brief Queues a full staging buffer for the I/O thread. The caller has
+ * waited for the previous one, so at most one buffer is in flight.
+ * @param data The full buffer.
+ * @param offset Its block-aligned file offset.
+ */
+void DirectFileWriter::submit(const char* data, std::uint64_t offset) {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    pendingData = data;
+    pendingOffset = offset;
+    ioBusy = true;
+    ioWake.notify_one();
+}
+
+/**
+ * @brief Blocks until the buffer in flight, if any, has been written. If it
+ * failed, its bytes are counted as lost and the active buffer, which follows
+ * it, moves back to its offset so the file has no gap.
+ */
+void DirectFileWriter::waitForIo() {
+    std::unique_lock<std::mutex> lock(ioMutex);
+    ioDone.wait(lock, [this] { return !ioBusy; });
+    if (ioFailed) {
+        ioFailed = false;
+        bufferOffset -= bufferBytes;
+        lostBytes += bufferBytes;
+    }
+}
+
+/**
+ * @brief Body of the I/O thread.
+ */
+void DirectFileWriter::ioLoop() {
+    std::unique_lock<std::mutex> lock(ioMutex);
+    for (;;) {
+        ioWake.wait(lock, [this] { return ioBusy || stopRequested; });
+        if (!ioBusy) {
+            break;
+        }
+        const char* data = pendingData;
+        std::uint64_t offset = pendingOffset;
+        lock.unlock();
+        bool written = writeAt(data, bufferBytes, offset);
+        lock.lock();
+        ioFailed = !written;
+        ioBusy = false;
+        ioDone.notify_all();
+    }
+}
+
+/**
+ * @brief Writes whole blocks at a block-aligned offset.
+ * @return false if the write failed.
+ */
+bool DirectFileWriter::writeAt(const char* data, std::size_t size, std::uint64_t offset) {
+    while (size > 0) {
+#ifdef _WIN32
+        OVERLAPPED position{};
+        position.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+        position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD written = 0;
+        if (!WriteFile(fileHandle, data, static_cast<DWORD>(size), &written, &position) || written == 0) {
+            std::cerr << "Error writing log file" << std::endl;
+            return false;
+        }
+#else
+        ssize_t written = ::pwrite(fileDescriptor, data, size, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            std::cerr << "Error writing log file: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+#endif
+        data += written;
+        size -= static_cast<std::size_t>(written);
+        offset += static_cast<std::uint64_t>(written);
+    }
+    return true;
+}
+
+/**
+ * @brief Reads whole blocks at a block-aligned offset; a short read at the end of the file is fine.
+ * @return false if the read failed.
+ */
+bool DirectFileWriter::readAt(char* data, std::size_t size, std::uint64_t offset) {
+#ifdef _WIN32
+    OVERLAPPED position{};
+    position.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+    position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD read = 0;
+    return ReadFile(fileHandle, data, static_cast<DWORD>(size), &read, &position) != 0;
+#else
+    return ::pread(fileDescriptor, data, size, static_cast<off_t>(offset)) >= 0;
+#endif
+}
+
+/**
+ * @brief Sets the file length, dropping the padding of the last block.
+ * @param size The number of bytes logged to the file.
+ */
+void DirectFileWriter::truncate(std::uint64_t size) {
+#ifdef _WIN32
+    FILE_END_OF_FILE_INFO endOfFile;
+    endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+    SetFileInformationByHandle(fileHandle, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile));
+#else
+    if (ftruncate(fileDescriptor, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Error truncating log file: " << std::strerror(errno) << std::endl;
+    }
+#endif
+}
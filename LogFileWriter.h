@@ -0,0 +1,213 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+enum class OutputMode {
+    Stream,  // buffered std::ofstream
+    Mapped,  // preallocated file written through a memory mapping
+    Vectored,// batches gathered in memory and written with one writev
+    Direct   // aligned blocks written around the page cache (O_DIRECT / FILE_FLAG_NO_BUFFERING)
+};
+
+struct LogFileWriterOptions {
+    OutputMode mode = OutputMode::Stream;
+    std::uint64_t mappedSegmentBytes = 64ull * 1024 * 1024;
+    std::size_t maxBatchRecords = 256;  // Vectored: appends per write call
+    int maxBatchLatencyMs = 5;          // Vectored: age of the oldest buffered append before it is written
+    std::size_t directBufferBytes = 1024 * 1024;  // Direct: size of each of the two staging buffers
+};
+
+/**
+ * @brief Output backend for the current log file.
+ * A writer is opened once per log file and closed on rotation. Appends are
+ * only issued by one thread at a time (the logger serializes them).
+ */
+class LogFileWriter {
+public:
+    virtual ~LogFileWriter() = default;
+
+    virtual bool open(const std::filesystem::path& path) = 0;
+    virtual bool write(std::string_view data) = 0;  // false if the data was not taken, e.g. the file cannot grow
+    virtual void flush() = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+    // Bytes of earlier successful write() calls that were lost when they were written out later,
+    // e.g. in a failed batch; the count is reset by the call
+    virtual std::uint64_t takeLostBytes() { return 0; }
+
+    static std::unique_ptr<LogFileWriter> create(const LogFileWriterOptions& options);
+    static bool recycle(const std::filesystem::path& from, const std::filesystem::path& to);
+    static void preallocate(const std::filesystem::path& path, std::uint64_t bytes);
+    static bool appendToFile(const std::filesystem::path& path, std::string_view data);
+};
+
+/**
+ * @brief Appends through a std::ofstream kept open between calls.
+ */
+class StreamFileWriter : public LogFileWriter {
+public:
+    bool open(const std::filesystem::path& path) override;
+    bool write(std::string_view data) override;
+    void flush() override;
+    void close() override;
+    bool isOpen() const override;
+
+private:
+    std::ofstream stream;
+};
+
+/**
+ * @brief Writes into a memory mapping of a preallocated file.
+ * The file is grown and remapped in segments of segmentBytes, so a log line is a
+ * plain memcpy until the segment is full. On close the file is truncated to the
+ * bytes actually written. Existing content is preserved when reopening a file.
+ */
+class MappedFileWriter : public LogFileWriter {
+public:
+    explicit MappedFileWriter(std::uint64_t segmentBytes);
+    ~MappedFileWriter() override;
+
+    bool open(const std::filesystem::path& path) override;
+    bool write(std::string_view data) override;
+    void flush() override;
+    void close() override;
+    bool isOpen() const override;
+
+private:
+    std::uint64_t segmentBytes;
+    std::uint64_t usedBytes = 0;
+    std::uint64_t flushedBytes = 0;  // end of the data already handed to writeback
+    std::uint64_t mappedBytes = 0;
+    char* view = nullptr;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+
+    bool map(std::uint64_t size);
+    void unmap();
+};
+
+/**
+ * @brief Collects appends in a few fixed-size chunks and writes each batch with
+ * a single gather call: writev on POSIX, one WriteFile per chunk on Windows
+ * (WriteFileGather needs unbuffered, page-aligned I/O).
+ * A batch is written once it holds maxBatchRecords appends, when an append
+ * finds the oldest buffered one older than maxBatchLatency, when its chunks
+ * are full, and on flush() and close(). The chunks are allocated once and reused.
+ * A batch that cannot be written is dropped and reported by takeLostBytes().
+ */
+class VectoredFileWriter : public LogFileWriter {
+public:
+    VectoredFileWriter(std::size_t maxBatchRecords, std::chrono::milliseconds maxBatchLatency);
+    ~VectoredFileWriter() override;
+
+    bool open(const std::filesystem::path& path) override;
+    bool write(std::string_view data) override;
+    void flush() override;
+    void close() override;
+    bool isOpen() const override;
+    std::uint64_t takeLostBytes() override;
+
+private:
+    static constexpr std::size_t chunkBytes = 64 * 1024;
+    static constexpr std::size_t maxChunks = 16;  // at most 1 MiB per batch, well below IOV_MAX
+
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        std::size_t capacity = 0;
+        std::size_t used = 0;
+    };
+
+    std::size_t maxBatchRecords;
+    std::chrono::milliseconds maxBatchLatency;
+    std::vector<Chunk> chunks;
+    std::size_t activeChunks = 0;
+    std::size_t batchRecords = 0;
+    std::chrono::steady_clock::time_point batchStart;
+    std::uint64_t lostBytes = 0;  // of batches that failed since the last takeLostBytes()
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+
+    Chunk& startChunk(std::size_t minimumBytes);
+    bool writeBatch();
+};
+
+/**
+ * @brief Writes block-aligned data with O_DIRECT (FILE_FLAG_NO_BUFFERING on
+ * Windows) so log files do not occupy the page cache.
+ * Appends are copied into one of two aligned staging buffers; a full buffer is
+ * handed to an I/O thread while the other one fills. flush() and close() write
+ * the partial last block padded to the block size and then truncate the file
+ * to the bytes actually logged, so the file always ends at its exact length.
+ * Reopening a file continues in its last partial block.
+ * When the I/O thread fails to write a buffer, the buffer after it takes its
+ * place in the file and its bytes are reported by takeLostBytes().
+ */
+class DirectFileWriter : public LogFileWriter {
+public:
+    explicit DirectFileWriter(std::size_t bufferBytes);
+    ~DirectFileWriter() override;
+
+    bool open(const std::filesystem::path& path) override;
+    bool write(std::string_view data) override;
+    void flush() override;
+    void close() override;
+    bool isOpen() const override;
+    std::uint64_t takeLostBytes() override;
+
+private:
+    static constexpr std::size_t blockBytes = 4096;  // covers the logical block size of common devices
+
+    struct AlignedDelete {
+        void operator()(char* buffer) const { ::operator delete[](buffer, std::align_val_t(blockBytes)); }
+    };
+    using AlignedBuffer = std::unique_ptr<char[], AlignedDelete>;
+
+    std::size_t bufferBytes;
+    AlignedBuffer buffers[2];
+    int activeBuffer = 0;
+    std::size_t fill = 0;            // bytes in the active buffer
+    std::uint64_t bufferOffset = 0;  // block-aligned file offset of the active buffer
+    std::uint64_t lostBytes = 0;     // of buffers that failed since the last takeLostBytes()
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+
+    // Hand-off of one full buffer to the I/O thread
+    std::mutex ioMutex;
+    std::condition_variable ioWake;
+    std::condition_variable ioDone;
+    const char* pendingData = nullptr;
+    std::uint64_t pendingOffset = 0;
+    bool ioBusy = false;
+    bool ioFailed = false;  // the buffer last in flight was not written
+    bool stopRequested = false;
+    std::thread ioThread;
+
+    bool writeTail();
+    void submit(const char* data, std::uint64_t offset);
+    void waitForIo();
+    void ioLoop();
+    bool writeAt(const char* data, std::size_t size, std::uint64_t offset);
+    bool readAt(char* data, std::size_t size, std::uint64_t offset);
+    void truncate(std::uint64_t size);
+};
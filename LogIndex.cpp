@@ -0,0 +1,302 @@
+#include "LogIndex.h"
+#include "Housekeeper.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    struct FileHeader {
+        char magic[8];
+        std::uint64_t fileSize;      // size of the log file the index describes
+        std::uint32_t segmentCount;  // LogIndex::Segment records that follow
+        std::uint32_t bloomBytes;    // bloom filter bytes after the segments, 0 if words are not indexed
+    };
+
+    static_assert(sizeof(FileHeader) == 24, "FileHeader must not contain padding");
+    static_assert(sizeof(LogIndex::Segment) == 24, "Segment must not contain padding");
+
+    constexpr std::string_view jsonTimePrefix = "{\"time\":\"";
+
+    bool readNumber(std::string_view text, std::size_t pos, std::size_t digits, int& value) {
+        value = 0;
+        for (std::size_t i = pos; i < pos + digits; ++i) {
+            if (text[i] < '0' || text[i] > '9') {
+                return false;
+            }
+            value = value * 10 + (text[i] - '0');
+        }
+        return true;
+    }
+
+    char lowerAscii(char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+}
+
+/**
+ * @brief Parses the timestamp a line starts with, in any of the precisions
+ * of TimestampPrecision.
+ * @param line A text or JSON log line, or just a timestamp.
+ * @param time Receives the local time as microseconds since the epoch.
+ * @return false if the line does not start with a timestamp, e.g. the
+ * continuation of a message that contains a newline.
+ */
+bool LogIndex::TimeParser::parse(std::string_view line, std::int64_t& time) {
+    if (line.starts_with(jsonTimePrefix)) {
+        line.remove_prefix(jsonTimePrefix.size());
+    }
+    if (line.size() < secondsLength || line[4] != '-' || line[7] != '-' || line[10] != ' ' || line[13] != ':' || line[16] != ':') {
+        return false;
+    }
+    if (!cached || std::memcmp(cachedText, line.data(), secondsLength) != 0) {
+        int fields[6];
+        constexpr std::size_t positions[6] = { 0, 5, 8, 11, 14, 17 };
+        for (int i = 0; i < 6; ++i) {
+            if (!readNumber(line, positions[i], i == 0 ? 4 : 2, fields[i])) {
+                return false;
+            }
+        }
+        std::tm timeInfo{};
+        timeInfo.tm_year = fields[0] - 1900;
+        timeInfo.tm_mon = fields[1] - 1;
+        timeInfo.tm_mday = fields[2];
+        timeInfo.tm_hour = fields[3];
+        timeInfo.tm_min = fields[4];
+        timeInfo.tm_sec = fields[5];
+        timeInfo.tm_isdst = -1;
+        std::time_t seconds = std::mktime(&timeInfo);
+        if (seconds == -1) {
+            return false;
+        }
+        std::memcpy(cachedText, line.data(), secondsLength);
+        cachedSeconds = static_cast<std::int64_t>(seconds);
+        cached = true;
+    }
+    std::int64_t micros = 0;
+    if (line.size() > secondsLength && line[secondsLength] == '.') {
+        int scale = 100000;
+        for (std::size_t i = secondsLength + 1; i < line.size() && scale > 0 && line[i] >= '0' && line[i] <= '9'; ++i) {
+            micros += (line[i] - '0') * scale;
+            scale /= 10;
+        }
+    }
+    time = cachedSeconds * 1000000 + micros;
+    return true;
+}
+
+/**
+ * @brief Sets the segment size and bloom filter size for the files indexed
+ * from now on, allocating the filter and room for initialSegments segments once.
+ * @param checkpointBytes Bytes of log lines per segment.
+ * @param bloomBytes Size of the bloom filter; 0 does not index words.
+ */
+void LogIndex::configure(std::size_t checkpointBytes, std::size_t bloomBytes) {
+    this->checkpointBytes = checkpointBytes;
+    segmentList.reserve(initialSegments);
+    bloom.assign(bloomBytes, 0);
+    clear();
+}
+
+/**
+ * @brief Starts over for a new file. Keeps the allocated capacity.
+ */
+void LogIndex::clear() {
+    segmentList.clear();
+    std::fill(bloom.begin(), bloom.end(), std::uint8_t{ 0 });
+    indexedSize = 0;
+}
+
+/**
+ * @brief Records a line that was appended to the file.
+ * @param offset Position of the line in the file.
+ * @param time The line's timestamp.
+ * @param line The line; its words are added to the bloom filter.
+ */
+void LogIndex::add(std::uint64_t offset, std::int64_t time, std::string_view line) {
+    if (segmentList.empty() || offset - segmentList.back().offset >= checkpointBytes) {
+        segmentList.push_back({ offset, time, time });
+    }
+    else {
+        Segment& segment = segmentList.back();
+        segment.minTime = std::min(segment.minTime, time);
+        segment.maxTime = std::max(segment.maxTime, time);
+    }
+    if (bloom.empty()) {
+        return;
+    }
+    std::size_t bits = bloom.size() * 8;
+    forEachWord(line, [this, bits](std::string_view word) {
+        std::uint64_t hash = hashWord(word);
+        std::uint64_t step = (hash >> 32) | 1;
+        for (unsigned i = 0; i < bloomHashes; ++i) {
+            std::size_t bit = static_cast<std::size_t>((hash + i * step) % bits);
+            bloom[bit / 8] |= static_cast<std::uint8_t>(1u << (bit % 8));
+        }
+        });
+}
+
+/**
+ * @brief Writes the index. The content is written to a temporary file and
+ * renamed, so a search never reads a partial index.
+ * @param path Where to write it, see pathFor().
+ * @param fileSize Current size of the log file; a search ignores the index
+ * once the file has grown past it.
+ * @return true if the index was written.
+ */
+bool LogIndex::save(const fs::path& path, std::uint64_t fileSize) const {
+    FileHeader header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.fileSize = fileSize;
+    header.segmentCount = static_cast<std::uint32_t>(segmentList.size());
+    header.bloomBytes = static_cast<std::uint32_t>(bloom.size());
+    fs::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(segmentList.data()), static_cast<std::streamsize>(segmentList.size() * sizeof(Segment)));
+        out.write(reinterpret_cast<const char*>(bloom.data()), static_cast<std::streamsize>(bloom.size()));
+        if (!out) {
+            return false;
+        }
+    }
+    std::error_code error;
+    fs::rename(temporary, path, error);
+    return !error;
+}
+
+/**
+ * @brief Reads an index written by save(). If configure() was called, the
+ * index must have a bloom filter of the configured size, so that lines can be
+ * added to it.
+ * @param path The index file.
+ * @return false if it is missing, damaged or has a different filter size.
+ */
+bool LogIndex::load(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    FileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        return false;
+    }
+    if (!bloom.empty() && header.bloomBytes != bloom.size()) {
+        return false;
+    }
+    segmentList.resize(header.segmentCount);
+    bloom.resize(header.bloomBytes);
+    if (!in.read(reinterpret_cast<char*>(segmentList.data()), static_cast<std::streamsize>(segmentList.size() * sizeof(Segment)))
+        || !in.read(reinterpret_cast<char*>(bloom.data()), static_cast<std::streamsize>(bloom.size()))) {
+        clear();
+        return false;
+    }
+    indexedSize = header.fileSize;
+    return true;
+}
+
+/**
+ * @brief Indexes an existing log file from its content, for a file the logger
+ * resumes without a matching index. Lines without a timestamp continue the
+ * message before them.
+ * @param logFile The text or JSON log file.
+ * @return false if it cannot be read.
+ */
+bool LogIndex::rebuild(const fs::path& logFile) {
+    std::ifstream in(logFile, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    clear();
+    TimeParser times;
+    std::string line;
+    std::uint64_t offset = 0;
+    std::int64_t time = 0;
+    bool timed = false;
+    while (std::getline(in, line)) {
+        std::uint64_t lineStart = offset;
+        offset += line.size() + 1;
+        if (times.parse(line, time)) {
+            timed = true;
+            add(lineStart, time, line);
+        }
+        else if (timed) {
+            // Continuation lines only contribute words, a segment never starts inside a message
+            Segment& segment = segmentList.back();
+            add(segment.offset, segment.maxTime, line);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns false if the file certainly contains no line with the word.
+ * Words are compared ignoring ASCII case.
+ * @param word A single word, see forEachWord().
+ */
+bool LogIndex::mayContain(std::string_view word) const {
+    if (bloom.empty()) {
+        return true;
+    }
+    std::size_t bits = bloom.size() * 8;
+    std::uint64_t hash = hashWord(word);
+    std::uint64_t step = (hash >> 32) | 1;
+    for (unsigned i = 0; i < bloomHashes; ++i) {
+        std::size_t bit = static_cast<std::size_t>((hash + i * step) % bits);
+        if ((bloom[bit / 8] & (1u << (bit % 8))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Finds the part of the file that holds every line in a time window:
+ * from the first segment with a line at or after from up to the end of the
+ * last segment with a line at or before to.
+ * @param from Start of the window, inclusive.
+ * @param to End of the window, inclusive.
+ * @param begin Receives the offset to start reading at.
+ * @param end Receives the offset to stop reading at.
+ * @return false if no line of the file falls in the window.
+ */
+bool LogIndex::byteRange(std::int64_t from, std::int64_t to, std::uint64_t& begin, std::uint64_t& end) const {
+    auto first = std::find_if(segmentList.begin(), segmentList.end(), [from](const Segment& segment) { return segment.maxTime >= from; });
+    auto last = std::find_if(segmentList.rbegin(), segmentList.rend(), [to](const Segment& segment) { return segment.minTime <= to; });
+    if (first == segmentList.end() || last == segmentList.rend() || last.base() <= first) {
+        return false;
+    }
+    begin = first->offset;
+    end = last.base() == segmentList.end() ? indexedSize : last.base()->offset;
+    return true;
+}
+
+/**
+ * @brief Returns the index file of a log file: "<name>.log.idx", also for a
+ * file that has since been compressed to "<name>.log.zst".
+ * @param logFile The log file.
+ */
+fs::path LogIndex::pathFor(const fs::path& logFile) {
+    fs::path path = logFile;
+    if (path.extension() == Housekeeper::compressedExtension) {
+        path.replace_extension();
+    }
+    path += extension;
+    return path;
+}
+
+/**
+ * @brief FNV-1a hash of a word with ASCII letters lowercased.
+ */
+std::uint64_t LogIndex::hashWord(std::string_view word) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : word) {
+        hash ^= static_cast<unsigned char>(lowerAscii(c));
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
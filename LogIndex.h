@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Sidecar index of a text or JSON log file, kept as "<name>.log.idx"
+ * next to it. The logger builds it while it writes the file and saves it when
+ * the file is retired and at shutdown. The file is split into segments that
+ * start on a line every checkpointBytes; each segment records the earliest and
+ * latest time of its lines, so a search can seek straight to the part of a
+ * file that covers a time window, even if lines were not logged in strict time
+ * order. Optionally a bloom filter of the words of every line lets a search
+ * skip files that cannot contain a word. Times are microseconds since the Unix
+ * epoch at the precision of the line timestamps.
+ */
+class LogIndex {
+public:
+    struct Segment {
+        std::uint64_t offset;  // start of the first line of the segment
+        std::int64_t minTime;  // earliest and latest line in the segment
+        std::int64_t maxTime;
+    };
+
+    /**
+     * @brief Reads the timestamp of a text line, or of the "time" member that
+     * starts a JSON line, as microseconds since the epoch. The local time of
+     * the last second seen is cached, so most lines cost no mktime() call.
+     */
+    class TimeParser {
+    public:
+        bool parse(std::string_view line, std::int64_t& time);
+
+    private:
+        static constexpr std::size_t secondsLength = 19;  // "YYYY-MM-DD HH:MM:SS"
+        char cachedText[secondsLength]{};
+        std::int64_t cachedSeconds = 0;
+        bool cached = false;
+    };
+
+    static constexpr const char* extension = ".idx";
+    static constexpr char magic[8] = { 'C', 'L', 'O', 'G', 'I', 'D', 'X', '1' };
+
+    void configure(std::size_t checkpointBytes, std::size_t bloomBytes);
+    void clear();
+    void add(std::uint64_t offset, std::int64_t time, std::string_view line);
+    bool save(const std::filesystem::path& path, std::uint64_t fileSize) const;
+    bool load(const std::filesystem::path& path);
+    bool rebuild(const std::filesystem::path& logFile);
+
+    std::uint64_t fileSize() const { return indexedSize; }
+    bool mayContain(std::string_view word) const;
+    bool byteRange(std::int64_t from, std::int64_t to, std::uint64_t& begin, std::uint64_t& end) const;
+
+    static std::filesystem::path pathFor(const std::filesystem::path& logFile);
+
+    /**
+     * @brief Calls visit with every word of text: runs of ASCII letters,
+     * digits and '_', and of bytes from 0x80 up, so UTF-8 words stay whole.
+     */
+    template <typename Visit>
+    static void forEachWord(std::string_view text, Visit&& visit) {
+        std::size_t start = 0;
+        for (std::size_t i = 0; i <= text.size(); ++i) {
+            if (i < text.size() && isWordChar(text[i])) {
+                continue;
+            }
+            if (i > start) {
+                visit(text.substr(start, i - start));
+            }
+            start = i + 1;
+        }
+    }
+
+    static bool isWordChar(char c) {
+        auto byte = static_cast<unsigned char>(c);
+        return (byte >= '0' && byte <= '9') || (byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z')
+            || byte == '_' || byte >= 0x80;
+    }
+
+private:
+    static constexpr unsigned bloomHashes = 4;
+    static constexpr std::size_t initialSegments = 4096;  // 96 KiB, a 256 MiB file at the default checkpoint size
+
+    std::size_t checkpointBytes = 64 * 1024;
+    std::vector<Segment> segmentList;
+    std::vector<std::uint8_t> bloom;  // empty if words are not indexed
+    std::uint64_t indexedSize = 0;    // size of the file when the loaded index was saved
+
+    static std::uint64_t hashWord(std::string_view word);
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#define CIRCULARLOGGER_LEVEL_TRACE 0
+#define CIRCULARLOGGER_LEVEL_DEBUG 1
+#define CIRCULARLOGGER_LEVEL_INFO 2
+#define CIRCULARLOGGER_LEVEL_WARN 3
+#define CIRCULARLOGGER_LEVEL_ERROR 4
+#define CIRCULARLOGGER_LEVEL_OFF 5
+
+// Lowest level the CLOG_* macros compile in; calls below it generate no code.
+// Release builds keep info and above unless the project defines otherwise.
+#ifndef CIRCULARLOGGER_MIN_LEVEL
+#ifdef NDEBUG
+#define CIRCULARLOGGER_MIN_LEVEL CIRCULARLOGGER_LEVEL_INFO
+#else
+#define CIRCULARLOGGER_MIN_LEVEL CIRCULARLOGGER_LEVEL_TRACE
+#endif
+#endif
+
+enum class LogLevel : std::uint8_t {
+    Trace = CIRCULARLOGGER_LEVEL_TRACE,
+    Debug = CIRCULARLOGGER_LEVEL_DEBUG,
+    Info = CIRCULARLOGGER_LEVEL_INFO,
+    Warn = CIRCULARLOGGER_LEVEL_WARN,
+    Error = CIRCULARLOGGER_LEVEL_ERROR,
+    Off = CIRCULARLOGGER_LEVEL_OFF  // threshold only: disables every level
+};
+
+/**
+ * @brief The name written in front of each message, e.g. "INFO".
+ */
+inline std::string_view logLevelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Trace: return "TRACE";
+    case LogLevel::Debug: return "DEBUG";
+    case LogLevel::Info: return "INFO";
+    case LogLevel::Warn: return "WARN";
+    case LogLevel::Error: return "ERROR";
+    default: return "OFF";
+    }
+}
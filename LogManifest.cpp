@@ -0,0 +1,188 @@
+#include "LogManifest.h"
+#include "BinaryLogFormat.h"
+
+#include <cstring>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+    constexpr int manifestVersion = 1;
+
+    // Length of the complete records of a binary log file of the given size
+    std::uint64_t validBinaryLength(std::ifstream& in, std::uint64_t size) {
+        std::uint64_t pos = sizeof(BinaryLogFormat::magic);
+        for (;;) {
+            BinaryLogFormat::MessageHeader header;
+            std::uint64_t headerSize = sizeof(BinaryLogFormat::FormatHeader);
+            if (pos + headerSize > size) {
+                return pos;
+            }
+            in.seekg(static_cast<std::streamoff>(pos));
+            if (!in.read(reinterpret_cast<char*>(&header), headerSize)) {
+                return pos;
+            }
+            std::uint64_t recordSize;
+            if (header.type == BinaryLogFormat::FormatDefinition) {
+                BinaryLogFormat::FormatHeader definition;
+                std::memcpy(&definition, &header, sizeof(definition));
+                recordSize = headerSize + definition.length;
+            }
+            else if (header.type == BinaryLogFormat::Message) {
+                headerSize = sizeof(BinaryLogFormat::MessageHeader);
+                if (pos + headerSize > size || !in.read(reinterpret_cast<char*>(&header) + sizeof(BinaryLogFormat::FormatHeader),
+                    headerSize - sizeof(BinaryLogFormat::FormatHeader))) {
+                    return pos;
+                }
+                recordSize = headerSize + header.payloadLength;
+            }
+            else {
+                return pos;  // zeroed or overwritten space after the last record
+            }
+            if (pos + recordSize > size) {
+                return pos;
+            }
+            pos += recordSize;
+        }
+    }
+
+    // Length up to and including the last newline of a text or JSON log file
+    std::uint64_t validTextLength(std::ifstream& in, std::uint64_t size) {
+        char buffer[64 * 1024];
+        std::uint64_t end = size;
+        while (end > 0) {
+            std::uint64_t chunk = end < sizeof(buffer) ? end : sizeof(buffer);
+            in.seekg(static_cast<std::streamoff>(end - chunk));
+            if (!in.read(buffer, static_cast<std::streamsize>(chunk))) {
+                return size;  // unreadable; leave the file alone
+            }
+            for (std::uint64_t i = chunk; i > 0; --i) {
+                if (buffer[i - 1] == '\n') {
+                    return end - chunk + i;
+                }
+            }
+            end -= chunk;
+        }
+        return 0;
+    }
+
+}
+
+/**
+ * @brief Reads the manifest of a log directory.
+ * @param directory The log directory.
+ * @return false if there is no manifest or it cannot be parsed, in which case
+ * the logger falls back to scanning the directory.
+ */
+bool LogManifest::load(const fs::path& directory) {
+    std::ifstream in(directory / fileName);
+    if (!in.is_open()) {
+        return false;
+    }
+    try {
+        json manifest;
+        in >> manifest;
+        if (manifest.value("version", 0) != manifestVersion) {
+            return false;
+        }
+        clean = manifest.value("clean", false);
+        format = manifest.value("format", 0);
+        rotationUnit = manifest.value("rotationUnit", 0);
+        frequency = manifest.value("frequency", 0);
+        nextRotationTime = manifest.value("nextRotationTime", static_cast<std::time_t>(0));
+        activeFile = manifest.value("activeFile", "");
+        periodName = manifest.value("periodName", "");
+        sequence = manifest.value("sequence", 0);
+        files.clear();
+        if (manifest.contains("files")) {
+            for (const auto& file : manifest.at("files")) {
+                files.push_back({ file.at("name").get<std::string>(), file.at("startTime").get<std::time_t>(),
+                    file.at("sequence").get<int>(), file.at("size").get<std::uint64_t>() });
+            }
+        }
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the manifest next to the log files. The new content is
+ * written to a temporary file and renamed over the old one, so a crash leaves
+ * either the previous or the new manifest.
+ * @param directory The log directory.
+ * @return true if the manifest was replaced.
+ */
+bool LogManifest::save(const fs::path& directory) const {
+    json manifest = {
+        {"version", manifestVersion},
+        {"clean", clean},
+        {"format", format},
+        {"rotationUnit", rotationUnit},
+        {"frequency", frequency},
+        {"nextRotationTime", nextRotationTime},
+        {"activeFile", activeFile},
+        {"periodName", periodName},
+        {"sequence", sequence},
+    };
+    {
+        json entries = json::array();
+        for (const Entry& file : files) {
+            entries.push_back({ {"name", file.name}, {"startTime", file.startTime}, {"sequence", file.sequence}, {"size", file.size} });
+        }
+        manifest["files"] = std::move(entries);
+    }
+    fs::path target = directory / fileName;
+    fs::path temporary = target;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << manifest.dump();
+        if (!out) {
+            return false;
+        }
+    }
+    std::error_code error;
+    fs::rename(temporary, target, error);
+    return !error;
+}
+
+/**
+ * @brief Cuts a log file back to its last complete record. A crash can leave a
+ * partly written line or binary record, or zeroed space that a mapped or
+ * direct writer had reserved, at the end of the active file. Text and JSON
+ * files end after their last newline; binary files after their last record
+ * whose header and payload are fully present.
+ * @param file A log file that is not open.
+ * @return The file's size after truncation.
+ */
+std::uint64_t LogManifest::truncateTornTail(const fs::path& file) {
+    std::error_code error;
+    std::uint64_t size = fs::file_size(file, error);
+    if (error || size == 0) {
+        return 0;
+    }
+    std::uint64_t valid = size;
+    {
+        std::ifstream in(file, std::ios::binary);
+        if (!in.is_open()) {
+            return size;
+        }
+        char magic[sizeof(BinaryLogFormat::magic)];
+        bool binary = size >= sizeof(magic) && in.read(magic, sizeof(magic))
+            && std::memcmp(magic, BinaryLogFormat::magic, sizeof(magic)) == 0;
+        in.clear();
+        valid = binary ? validBinaryLength(in, size) : validTextLength(in, size);
+    }
+    if (valid < size) {
+        fs::resize_file(file, valid, error);
+        if (error) {
+            return size;
+        }
+    }
+    return valid;
+}
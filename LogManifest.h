@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Small state file ("manifest.json") kept in the log directory so a
+ * restarted logger neither scans the directory nor starts a new file.
+ * It records the active file, its rotation deadline and the retention index,
+ * and is rewritten at every rotation, marked unclean until a clean shutdown.
+ * At startup a clean manifest replaces the directory scan. An unclean one (a
+ * crash) does too once a few files have been checked: the housekeeping
+ * thread writes it after the deletions and compressions queued before it,
+ * so only a rotation whose manifest was never written leaves the directory
+ * ahead of it, and that shows as a successor of the active file.
+ */
+struct LogManifest {
+    struct Entry {
+        std::string name;        // file name within the log directory
+        std::time_t startTime;
+        int sequence;
+        std::uint64_t size;
+    };
+
+    static constexpr const char* fileName = "manifest.json";
+
+    bool clean = false;
+    int format = 0;              // LogFormat, RotationUnit and frequency the deadline was computed with
+    int rotationUnit = 0;
+    int frequency = 0;
+    std::time_t nextRotationTime = 0;  // 0 if there is no file to resume
+    std::string activeFile;
+    std::string periodName;
+    int sequence = 0;
+    std::vector<Entry> files;    // oldest first; the active file's size is only final in a clean manifest
+
+    bool load(const std::filesystem::path& directory);
+    bool save(const std::filesystem::path& directory) const;
+    static std::uint64_t truncateTornTail(const std::filesystem::path& file);
+};
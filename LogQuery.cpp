@@ -0,0 +1,106 @@
+#include "LogIndex.h"
+#include "LogSearch.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+    /**
+     * @brief Prints command line usage.
+     */
+    void printUsage() {
+        std::cerr << "Usage: LogQuery <log directory> [-from <time>] [-to <time>] [-w <word>]... [-o <output file>] [-v]\n"
+            << "Prints the lines of the text and JSON log files in the directory that were logged between -from and -to\n"
+            << "and contain every -w word (whole words, ignoring case). Times are local, \"YYYY-MM-DD HH:MM:SS[.ffffff]\";\n"
+            << "-to includes the whole second it names unless it has a fraction. -v reports what the indexes let it skip.\n";
+    }
+
+    /**
+     * @brief Parses a -from or -to argument.
+     * @param text The argument.
+     * @param roundUp true to move a time without fraction to the end of its second.
+     * @param time Receives the time in microseconds since the epoch.
+     * @return false if the argument is not a timestamp.
+     */
+    bool parseTime(const std::string& text, bool roundUp, std::int64_t& time) {
+        LogIndex::TimeParser parser;
+        if (!parser.parse(text, time)) {
+            return false;
+        }
+        if (roundUp && text.find('.') == std::string::npos) {
+            time += 999999;
+        }
+        return true;
+    }
+
+}
+
+/**
+ * @brief Entry point of the search tool for retained log files.
+ */
+int main(int argc, char* argv[]) {
+    std::string directory;
+    std::string outputPath;
+    bool verbose = false;
+    LogSearchQuery query;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "-from" && i + 1 < argc) {
+            if (!parseTime(argv[++i], false, query.from)) {
+                printUsage();
+                return 2;
+            }
+        }
+        else if (argument == "-to" && i + 1 < argc) {
+            if (!parseTime(argv[++i], true, query.to)) {
+                printUsage();
+                return 2;
+            }
+        }
+        else if (argument == "-w" && i + 1 < argc) {
+            query.words.push_back(argv[++i]);
+        }
+        else if (argument == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        }
+        else if (argument == "-v") {
+            verbose = true;
+        }
+        else if (directory.empty() && argument[0] != '-') {
+            directory = argument;
+        }
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (directory.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    std::ofstream outputFile;
+    if (!outputPath.empty()) {
+        outputFile.open(outputPath, std::ios::binary | std::ios::trunc);
+        if (!outputFile) {
+            std::cerr << "Cannot write " << outputPath << '\n';
+            return 1;
+        }
+    }
+    std::ostream& out = outputPath.empty() ? std::cout : outputFile;
+
+    std::size_t matches = 0;
+    LogSearchStats stats = LogSearch::search(directory, query, [&out, &matches](const std::filesystem::path&, std::string_view line) {
+        out << line << '\n';
+        ++matches;
+        });
+    for (const auto& file : stats.compressedFiles) {
+        std::cerr << "Not searched, compressed: " << file.string() << '\n';
+    }
+    if (verbose) {
+        std::cerr << matches << " matching lines; " << stats.filesSearched << " files read (" << stats.filesUnindexed
+            << " without index), " << stats.filesSkipped << " skipped by their index, " << stats.bytesRead << " bytes read\n";
+    }
+    return out ? 0 : 1;
+}
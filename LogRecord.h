@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include "ArgumentCodec.h"
+#include "LogLevel.h"
+#include "SlabPool.h"
+
+/**
+ * @brief Small sequential number identifying the calling thread for its lifetime.
+ */
+inline std::uint32_t currentThreadNumber() {
+    static std::atomic<std::uint32_t> nextNumber{ 1 };
+    thread_local std::uint32_t number = nextNumber.fetch_add(1, std::memory_order_relaxed);
+    return number;
+}
+
+/**
+ * @brief A single queued log message as stored in a ring buffer slot.
+ * Short messages are copied into the inline buffer so that enqueueing does not
+ * allocate; longer ones go to a block of the queue's SlabPool, which the writer
+ * returns with releaseSlab() once the record is written, or, if the pool is
+ * exhausted or the message larger than a block, into a string that keeps its
+ * capacity between uses.
+ * A deferred record holds encoded format arguments instead of text, plus the
+ * format string and the function that turns them into text on the writer thread.
+ * A structured record keeps its fields, already rendered in the file's format,
+ * right after the message text.
+ */
+struct LogRecord {
+    // Output iterator that stops storing at the end of a buffer but keeps counting
+    struct TruncatingIterator {
+        using iterator_category = std::output_iterator_tag;
+        using value_type = void;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = void;
+
+        char* position;
+        char* end;
+        std::size_t count;
+
+        TruncatingIterator& operator*() { return *this; }
+        TruncatingIterator& operator++() { return *this; }
+        TruncatingIterator& operator++(int) { return *this; }
+        TruncatingIterator& operator=(char c) {
+            if (position != end) {
+                *position++ = c;
+            }
+            ++count;
+            return *this;
+        }
+    };
+
+    static constexpr std::size_t inlineCapacity = 232;
+
+    std::chrono::system_clock::time_point time;
+    std::uint32_t threadId = 0;
+    LogLevel level = LogLevel::Info;
+    std::uint32_t length = 0;
+    std::uint32_t messageLength = 0;                // text before the rendered fields
+    std::string overflow;
+    SlabPool* slabs = nullptr;                      // set once for every slot of the queue
+    char* slab = nullptr;                           // block holding a long payload until releaseSlab()
+    std::string_view format;                        // deferred records only
+    ArgumentCodec::Formatter formatter = nullptr;   // null for plain text records
+    char text[inlineCapacity];
+
+    void assign(std::chrono::system_clock::time_point recordTime, LogLevel recordLevel, std::string_view message,
+        std::string_view fields = std::string_view()) {
+        time = recordTime;
+        threadId = currentThreadNumber();
+        level = recordLevel;
+        formatter = nullptr;
+        messageLength = static_cast<std::uint32_t>(message.size());
+        length = static_cast<std::uint32_t>(message.size() + fields.size());
+        if (length <= inlineCapacity) {
+            std::memcpy(text, message.data(), message.size());
+            std::memcpy(text + message.size(), fields.data(), fields.size());
+        }
+        else if (char* block = acquireSlab(length)) {
+            std::memcpy(block, message.data(), message.size());
+            std::memcpy(block + message.size(), fields.data(), fields.size());
+        }
+        else {
+            overflow.assign(message.data(), message.size());
+            overflow.append(fields.data(), fields.size());
+        }
+    }
+
+    /**
+     * @brief Formats a message directly into the record. A result that does
+     * not fit inline is formatted again into a slab or the overflow string.
+     */
+    void assignFormatted(std::chrono::system_clock::time_point recordTime, LogLevel recordLevel,
+        std::string_view format, std::format_args args) {
+        time = recordTime;
+        threadId = currentThreadNumber();
+        level = recordLevel;
+        formatter = nullptr;
+        TruncatingIterator out = std::vformat_to(TruncatingIterator{ text, text + inlineCapacity, 0 }, format, args);
+        if (out.count > inlineCapacity) {
+            if (char* block = acquireSlab(out.count)) {
+                std::vformat_to(TruncatingIterator{ block, block + out.count, 0 }, format, args);
+            }
+            else {
+                overflow.clear();
+                std::vformat_to(std::back_inserter(overflow), format, args);
+            }
+        }
+        length = static_cast<std::uint32_t>(out.count);
+        messageLength = length;
+    }
+
+    /**
+     * @brief Stores encoded arguments to be formatted later by recordFormatter.
+     */
+    void assignEncoded(std::chrono::system_clock::time_point recordTime, LogLevel recordLevel, std::string_view recordFormat,
+        ArgumentCodec::Formatter recordFormatter, std::string_view encodedArguments) {
+        assign(recordTime, recordLevel, encodedArguments);
+        format = recordFormat;
+        formatter = recordFormatter;
+    }
+
+    /**
+     * @brief The message text, or the encoded arguments of a deferred record.
+     */
+    std::string_view message() const {
+        return payload().substr(0, messageLength);
+    }
+
+    /**
+     * @brief The rendered fields of a structured record, empty for any other.
+     */
+    std::string_view fields() const {
+        return payload().substr(messageLength);
+    }
+
+    std::string_view payload() const {
+        if (length <= inlineCapacity) {
+            return std::string_view(text, length);
+        }
+        return holdsInSlab(length) ? std::string_view(slab, length) : std::string_view(overflow);
+    }
+
+    /**
+     * @brief Gives the slab back to the pool once the record has been written or discarded.
+     */
+    void releaseSlab() {
+        if (slab != nullptr) {
+            slabs->release(slab);
+            slab = nullptr;
+        }
+    }
+
+private:
+    bool holdsInSlab(std::size_t size) const {
+        return slab != nullptr && size <= slabs->slabBytes();
+    }
+
+    // The record's slab for a payload of size bytes, taken from the pool if needed; nullptr if it cannot have one
+    char* acquireSlab(std::size_t size) {
+        if (slabs == nullptr || size > slabs->slabBytes()) {
+            return nullptr;
+        }
+        if (slab == nullptr) {
+            slab = slabs->acquire();
+        }
+        return slab;
+    }
+};
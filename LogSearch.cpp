@@ -0,0 +1,142 @@
+#include "LogSearch.h"
+#include "Housekeeper.h"
+#include "LogIndex.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    bool equalsIgnoringCase(std::string_view a, std::string_view b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) {
+            auto lower = [](char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; };
+            return lower(x) == lower(y);
+            });
+    }
+
+    // Sort key of a log file name "<period>[.<part>].log[.zst]"
+    struct FileOrder {
+        std::string period;
+        int part = 0;
+
+        bool operator<(const FileOrder& other) const {
+            return period != other.period ? period < other.period : part < other.part;
+        }
+    };
+
+    FileOrder fileOrder(const fs::path& file) {
+        std::string name = file.filename().string();
+        FileOrder order;
+        std::size_t dot = name.find('.');
+        order.period = name.substr(0, dot);
+        std::size_t pos = dot + 1;
+        while (pos < name.size() && name[pos] >= '0' && name[pos] <= '9') {
+            order.part = order.part * 10 + (name[pos++] - '0');
+        }
+        return order;
+    }
+
+}
+
+/**
+ * @brief Runs a search over one log directory.
+ * @param directory The log directory.
+ * @param query Time window and words to look for.
+ * @param onLine Called for every matching line, without its newline, in file order.
+ * @return What was read and skipped.
+ */
+LogSearchStats LogSearch::search(const fs::path& directory, const LogSearchQuery& query, const LineHandler& onLine) {
+    LogSearchStats stats;
+    std::vector<std::string_view> words;
+    for (const std::string& text : query.words) {
+        LogIndex::forEachWord(text, [&words](std::string_view word) { words.push_back(word); });
+    }
+
+    std::string line;
+    for (const fs::path& file : logFiles(directory)) {
+        bool compressed = file.extension() == Housekeeper::compressedExtension;
+        std::error_code error;
+        std::uint64_t size = compressed ? 0 : fs::file_size(file, error);
+        std::uint64_t begin = 0;
+        std::uint64_t end = std::numeric_limits<std::uint64_t>::max();
+
+        // An index is only trusted for the file it was saved with; a compressed file no longer changes
+        LogIndex index;
+        bool indexed = index.load(LogIndex::pathFor(file)) && (compressed || (!error && index.fileSize() == size));
+        if (indexed) {
+            bool possible = std::all_of(words.begin(), words.end(), [&index](std::string_view word) { return index.mayContain(word); })
+                && index.byteRange(query.from, query.to, begin, end);
+            if (!possible) {
+                ++stats.filesSkipped;
+                continue;
+            }
+        }
+        if (compressed) {
+            stats.compressedFiles.push_back(file);
+            continue;
+        }
+        std::ifstream in(file, std::ios::binary);
+        if (!in.is_open()) {
+            continue;
+        }
+        ++stats.filesSearched;
+        if (!indexed) {
+            ++stats.filesUnindexed;
+        }
+
+        in.seekg(static_cast<std::streamoff>(begin));
+        std::uint64_t offset = begin;
+        LogIndex::TimeParser times;
+        std::int64_t time = std::numeric_limits<std::int64_t>::min();  // until the first timestamp
+        while (offset < end && std::getline(in, line)) {
+            offset += line.size() + 1;
+            stats.bytesRead += line.size() + 1;
+            if (!line.empty() && line[0] == '\0') {
+                break;  // space a crash left zeroed after the last line
+            }
+            times.parse(line, time);
+            if (time < query.from || time > query.to) {
+                continue;
+            }
+            if (std::all_of(words.begin(), words.end(), [&line](std::string_view word) { return containsWord(line, word); })) {
+                onLine(file, line);
+            }
+        }
+    }
+    return stats;
+}
+
+/**
+ * @brief Lists the log files of a directory, oldest first. Other files in
+ * it, such as indexes, the manifest or a crash dump, are left out.
+ * @param directory The log directory.
+ */
+std::vector<fs::path> LogSearch::logFiles(const fs::path& directory) {
+    std::vector<fs::path> files;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(directory, error)) {
+        std::string name = entry.path().filename().string();
+        std::string_view stem = name;
+        if (stem.ends_with(Housekeeper::compressedExtension)) {
+            stem.remove_suffix(std::string_view(Housekeeper::compressedExtension).size());
+        }
+        if (entry.is_regular_file() && stem.ends_with(".log") && !stem.empty() && stem[0] >= '0' && stem[0] <= '9') {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end(), [](const fs::path& a, const fs::path& b) { return fileOrder(a) < fileOrder(b); });
+    return files;
+}
+
+/**
+ * @brief Returns true if the line contains the word as a whole word, ignoring ASCII case.
+ */
+bool LogSearch::containsWord(std::string_view line, std::string_view word) {
+    bool found = false;
+    LogIndex::forEachWord(line, [&found, word](std::string_view candidate) {
+        found = found || equalsIgnoringCase(candidate, word);
+        });
+    return found;
+}
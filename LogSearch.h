@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct LogSearchQuery {
+    std::int64_t from = std::numeric_limits<std::int64_t>::min();  // inclusive, microseconds since the epoch
+    std::int64_t to = std::numeric_limits<std::int64_t>::max();    // inclusive
+    std::vector<std::string> words;  // a line matches if it contains each one as a whole word, ignoring ASCII case
+};
+
+struct LogSearchStats {
+    std::size_t filesSearched = 0;     // files that were read, completely or from an index checkpoint
+    std::size_t filesSkipped = 0;      // files their index ruled out
+    std::size_t filesUnindexed = 0;    // files read from start to end because they have no valid index
+    std::vector<std::filesystem::path> compressedFiles;  // may match but cannot be read here
+    std::uint64_t bytesRead = 0;
+};
+
+/**
+ * @brief Searches the text and JSON log files of a log directory, oldest
+ * first. A file's LogIndex, where present and up to date, is used to skip the
+ * file if its time range or bloom filter rules it out, and otherwise to read
+ * only the byte range that covers the time window; other files are read
+ * completely. Lines of a message that spans several lines share the time of
+ * its first line.
+ */
+class LogSearch {
+public:
+    using LineHandler = std::function<void(const std::filesystem::path& file, std::string_view line)>;
+
+    static LogSearchStats search(const std::filesystem::path& directory, const LogSearchQuery& query, const LineHandler& onLine);
+
+private:
+    static std::vector<std::filesystem::path> logFiles(const std::filesystem::path& directory);
+    static bool containsWord(std::string_view line, std::string_view word);
+};
@@ -0,0 +1,78 @@
+#include "LoggerRegistry.h"
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Constructor for LoggerRegistry.
+ * @param configDirectory Directory holding one "<name>.json" configuration per channel.
+ * @param logRoot Parent of the default log directories, "<logRoot>/<name>".
+ */
+LoggerRegistry::LoggerRegistry(const std::string& configDirectory, const std::string& logRoot)
+    : configDirectory(configDirectory), logRoot(logRoot) {
+    std::error_code error;
+    fs::create_directories(configDirectory, error);
+}
+
+/**
+ * @brief Destructor. Every channel writes its queued messages before the
+ * shared threads stop.
+ */
+LoggerRegistry::~LoggerRegistry() {
+    std::lock_guard<std::mutex> lock(channelsMutex);
+    channels.clear();
+}
+
+/**
+ * @brief Returns the channel with the given name, creating it on first use.
+ * A new channel reads "<configDirectory>/<name>.json", which is created with
+ * defaults if missing, and logs to "<logRoot>/<name>" unless the configuration
+ * sets "logDirectory". The reference stays valid for the registry's lifetime.
+ * @param name Channel name; also used as a file name, so it should not contain path separators.
+ * @return The channel's logger.
+ */
+CircularLogger& LoggerRegistry::channel(const std::string& name) {
+    std::lock_guard<std::mutex> lock(channelsMutex);
+    auto existing = channels.find(name);
+    if (existing != channels.end()) {
+        return *existing->second;
+    }
+    LoggerContext context;
+    context.writer = &writer;
+    context.housekeeper = &housekeeper;
+    context.defaultLogDirectory = (fs::path(logRoot) / name).string();
+    std::string configPath = (fs::path(configDirectory) / (name + ".json")).string();
+    auto created = channels.emplace(name, std::make_unique<CircularLogger>(configPath, context));
+    return *created.first->second;
+}
+
+/**
+ * @brief Returns the channel with the given name, or nullptr if it was never created.
+ */
+CircularLogger* LoggerRegistry::find(const std::string& name) {
+    std::lock_guard<std::mutex> lock(channelsMutex);
+    auto existing = channels.find(name);
+    return existing == channels.end() ? nullptr : existing->second.get();
+}
+
+/**
+ * @brief Returns the names of all channels in alphabetical order.
+ */
+std::vector<std::string> LoggerRegistry::channelNames() const {
+    std::lock_guard<std::mutex> lock(channelsMutex);
+    std::vector<std::string> names;
+    names.reserve(channels.size());
+    for (const auto& entry : channels) {
+        names.push_back(entry.first);
+    }
+    return names;
+}
+
+/**
+ * @brief Flushes every channel; see CircularLogger::flush().
+ */
+void LoggerRegistry::flush() {
+    std::lock_guard<std::mutex> lock(channelsMutex);
+    for (auto& entry : channels) {
+        entry.second->flush();
+    }
+}
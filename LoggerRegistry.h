@@ -0,0 +1,35 @@
+#pragma once
+
+#include "CircularLogger.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Named loggers ("channels") that share one writer thread and one
+ * housekeeping thread. Each channel has its own configuration file, log
+ * directory, rotation and retention; async channels are all drained by the
+ * same writer, so adding channels does not add threads competing for the disk.
+ */
+class LoggerRegistry {
+public:
+    explicit LoggerRegistry(const std::string& configDirectory = "channels", const std::string& logRoot = "Logs");
+    ~LoggerRegistry();
+    LoggerRegistry(const LoggerRegistry&) = delete;
+    LoggerRegistry& operator=(const LoggerRegistry&) = delete;
+
+    CircularLogger& channel(const std::string& name);
+    CircularLogger* find(const std::string& name);
+    std::vector<std::string> channelNames() const;
+    void flush();
+
+private:
+    std::string configDirectory;
+    std::string logRoot;
+    Housekeeper housekeeper;
+    WriterThread writer;
+    mutable std::mutex channelsMutex;
+    std::map<std::string, std::unique_ptr<CircularLogger>> channels; // destroyed before the shared threads
+};
@@ -0,0 +1,183 @@
+#include "LoggerStats.h"
+
+#include <algorithm>
+#include <bit>
+
+struct ThreadLocalCounter::ThreadCells {
+    std::vector<std::unique_ptr<Cell>> bySlot;
+
+    ThreadCells();
+    ~ThreadCells();
+};
+
+struct ThreadLocalCounter::Registry {
+    std::mutex mutex;
+    std::vector<ThreadLocalCounter*> counters;  // by slot, null while the slot is free
+    std::vector<std::size_t> freeSlots;
+    std::vector<ThreadCells*> threads;
+};
+
+thread_local ThreadLocalCounter::ThreadCells ThreadLocalCounter::threadCells;
+
+/**
+ * @brief Returns an upper bound of the duration below which the given fraction
+ * of the recorded durations fall, at the resolution of the buckets.
+ * @param fraction Percentile as a fraction, e.g. 0.99.
+ * @return The upper edge of the matching bucket in nanoseconds, or 0 if nothing was recorded.
+ */
+std::uint64_t LatencyHistogram::percentileNanos(double fraction) const {
+    if (count == 0) {
+        return 0;
+    }
+    auto rank = static_cast<std::uint64_t>(fraction * static_cast<double>(count));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+        seen += buckets[i];
+        if (seen > rank) {
+            return std::min(maxNanos, (std::uint64_t{ 1 } << (i + 1)) - 1);
+        }
+    }
+    return maxNanos;
+}
+
+/**
+ * @brief Adds one duration. Must not be called by two threads at once.
+ * @param elapsed The measured duration.
+ */
+void LatencyRecorder::record(std::chrono::steady_clock::duration elapsed) {
+    auto nanos = static_cast<std::uint64_t>(std::max<std::int64_t>(0,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    std::size_t bucket = nanos == 0 ? 0 : static_cast<std::size_t>(std::bit_width(nanos)) - 1;
+    buckets[std::min(bucket, LatencyHistogram::bucketCount - 1)].add(1);
+    count.add(1);
+    totalNanos.add(nanos);
+    maxNanos.raiseTo(nanos);
+}
+
+/**
+ * @brief Copies the current distribution. Safe to call while durations are recorded;
+ * the copy may then miss the latest one.
+ */
+LatencyHistogram LatencyRecorder::snapshot() const {
+    LatencyHistogram histogram;
+    for (std::size_t i = 0; i < LatencyHistogram::bucketCount; ++i) {
+        histogram.buckets[i] = buckets[i].load();
+    }
+    histogram.count = count.load();
+    histogram.totalNanos = totalNanos.load();
+    histogram.maxNanos = maxNanos.load();
+    return histogram;
+}
+
+/**
+ * @brief Returns the process-wide registry. Built on first use, so counters
+ * constructed during static initialization find it.
+ */
+ThreadLocalCounter::Registry& ThreadLocalCounter::registry() {
+    static Registry instance;
+    return instance;
+}
+
+/**
+ * @brief Constructor for a thread's table. Registers it so destroyed counters
+ * can free their cell in it.
+ */
+ThreadLocalCounter::ThreadCells::ThreadCells() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    shared.threads.push_back(this);
+}
+
+/**
+ * @brief Destructor, run when the thread exits. Moves the count of each cell
+ * into its counter's retired total before the cell is freed.
+ */
+ThreadLocalCounter::ThreadCells::~ThreadCells() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> registryLock(shared.mutex);
+    for (std::size_t i = 0; i < bySlot.size(); ++i) {
+        if (!bySlot[i]) {
+            continue;
+        }
+        ThreadLocalCounter& counter = *shared.counters[i];
+        std::lock_guard<std::mutex> lock(counter.cellsMutex);
+        counter.retired.add(bySlot[i]->value.load());
+        counter.cells.erase(std::find(counter.cells.begin(), counter.cells.end(), bySlot[i].get()));
+    }
+    shared.threads.erase(std::find(shared.threads.begin(), shared.threads.end(), this));
+}
+
+/**
+ * @brief Constructor for ThreadLocalCounter. Takes a free slot, or a new one.
+ */
+ThreadLocalCounter::ThreadLocalCounter() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    if (shared.freeSlots.empty()) {
+        slot = shared.counters.size();
+        shared.counters.push_back(this);
+    }
+    else {
+        slot = shared.freeSlots.back();
+        shared.freeSlots.pop_back();
+        shared.counters[slot] = this;
+    }
+}
+
+/**
+ * @brief Destructor. Frees the counter's cell in every live thread's table,
+ * then releases the slot. No thread may increment the counter meanwhile.
+ */
+ThreadLocalCounter::~ThreadLocalCounter() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    for (ThreadCells* thread : shared.threads) {
+        if (slot < thread->bySlot.size()) {
+            thread->bySlot[slot].reset();
+        }
+    }
+    shared.counters[slot] = nullptr;
+    shared.freeSlots.push_back(slot);
+}
+
+/**
+ * @brief Adds one to the calling thread's cell. Only the first increment on a
+ * thread takes a lock.
+ */
+void ThreadLocalCounter::increment() {
+    std::vector<std::unique_ptr<Cell>>& owned = threadCells.bySlot;
+    if (slot < owned.size() && owned[slot]) {
+        owned[slot]->value.add(1);
+        return;
+    }
+    registerThread().add(1);
+}
+
+/**
+ * @brief Sums the cells of the live threads and the counts of exited ones.
+ */
+std::uint64_t ThreadLocalCounter::total() const {
+    std::lock_guard<std::mutex> lock(cellsMutex);
+    std::uint64_t sum = retired.load();
+    for (const Cell* cell : cells) {
+        sum += cell->value.load();
+    }
+    return sum;
+}
+
+/**
+ * @brief Creates the calling thread's cell at the counter's slot of its table.
+ * @return The new cell.
+ */
+StatCounter& ThreadLocalCounter::registerThread() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> registryLock(shared.mutex);
+    std::vector<std::unique_ptr<Cell>>& owned = threadCells.bySlot;
+    if (owned.size() <= slot) {
+        owned.resize(slot + 1);
+    }
+    owned[slot] = std::make_unique<Cell>();
+    std::lock_guard<std::mutex> lock(cellsMutex);
+    cells.push_back(owned[slot].get());
+    return owned[slot]->value;
+}
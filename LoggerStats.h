@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Distribution of durations in power-of-two nanosecond buckets:
+ * bucket i counts durations in [2^i, 2^(i+1)) ns, bucket 0 also counts 0.
+ */
+struct LatencyHistogram {
+    static constexpr std::size_t bucketCount = 40;  // the last bucket also holds everything above ~9 minutes
+
+    std::array<std::uint64_t, bucketCount> buckets{};
+    std::uint64_t count = 0;
+    std::uint64_t totalNanos = 0;
+    std::uint64_t maxNanos = 0;
+
+    std::uint64_t percentileNanos(double fraction) const;
+};
+
+/**
+ * @brief Snapshot of a logger's self-instrumentation, returned by CircularLogger::stats().
+ */
+struct LoggerStats {
+    std::uint64_t messagesLogged = 0;   // passed the level check
+    std::uint64_t messagesDropped = 0;  // discarded by the overflow policy
+    std::uint64_t messagesSuppressed = 0; // held back by the rate limit of a CLOG_*_LIMITED call site
+    std::uint64_t bytesWritten = 0;     // handed to the log files, including binary framing
+    std::uint64_t writeErrors = 0;      // appends or batches the output backend failed to write, not in bytesWritten
+    std::uint64_t flushes = 0;
+    std::uint64_t rotations = 0;
+    std::size_t queueHighWater = 0;     // deepest queue seen by the writer thread, async mode only
+    std::uint64_t networkSent = 0;      // lines delivered to the network sink's collector
+    std::uint64_t networkDropped = 0;   // lines the network sink could neither buffer nor spill
+    LatencyHistogram writeLatency;      // appends to the output backend, one in 16 is timed
+    LatencyHistogram flushLatency;      // each flush of the output backend
+    LatencyHistogram rotationLatency;   // each call to rotateLogs()
+};
+
+/**
+ * @brief Counter updated by one thread at a time (for instance under a mutex) and
+ * read by any thread. Updates are a plain load and store, never a locked
+ * read-modify-write.
+ */
+class StatCounter {
+public:
+    void add(std::uint64_t amount) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    void subtract(std::uint64_t amount) {
+        value.store(value.load(std::memory_order_relaxed) - amount, std::memory_order_relaxed);
+    }
+    void raiseTo(std::uint64_t candidate) {
+        if (candidate > value.load(std::memory_order_relaxed)) {
+            value.store(candidate, std::memory_order_relaxed);
+        }
+    }
+    std::uint64_t load() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> value{ 0 };
+};
+
+/**
+ * @brief Live LatencyHistogram with the same single-updater rule as StatCounter.
+ */
+class LatencyRecorder {
+public:
+    void record(std::chrono::steady_clock::duration elapsed);
+    LatencyHistogram snapshot() const;
+
+private:
+    std::array<StatCounter, LatencyHistogram::bucketCount> buckets;
+    StatCounter count;
+    StatCounter totalNanos;
+    StatCounter maxNanos;
+};
+
+/**
+ * @brief Counter incremented from any number of threads without contention.
+ * Each thread adds to its own cache-line sized cell, found at the counter's
+ * slot in a per-thread table and registered on the thread's first increment;
+ * total() sums the cells. When a thread exits, its cells are folded into the
+ * counters' retired totals and freed, so their counts are kept but not the cells.
+ */
+class ThreadLocalCounter {
+public:
+    ThreadLocalCounter();
+    ~ThreadLocalCounter();
+    ThreadLocalCounter(const ThreadLocalCounter&) = delete;
+    ThreadLocalCounter& operator=(const ThreadLocalCounter&) = delete;
+
+    void increment();
+    std::uint64_t total() const;
+
+private:
+    struct alignas(64) Cell {
+        StatCounter value;
+    };
+    struct ThreadCells;  // a thread's cells, indexed by counter slot
+    struct Registry;     // live counters and thread tables
+
+    std::size_t slot;  // reused by a later counter only after every thread has dropped its cell
+    mutable std::mutex cellsMutex;
+    std::vector<Cell*> cells;  // owned by the threads' tables
+    StatCounter retired;       // counts of exited threads, updated under cellsMutex
+
+    static thread_local ThreadCells threadCells;
+    static Registry& registry();
+    StatCounter& registerThread();
+};
@@ -0,0 +1,496 @@
+#include "NetworkSink.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    constexpr auto connectTimeout = std::chrono::milliseconds(1000);
+    constexpr auto blockedRetry = std::chrono::milliseconds(10);  // wait before retrying a send the collector did not take
+    constexpr auto initialBackoff = std::chrono::milliseconds(100);
+    constexpr std::size_t maxDatagramLine = 65000;  // leaves room for the priority and IP/UDP headers
+
+#ifdef _WIN32
+    using NativeSocket = SOCKET;
+    constexpr NativeSocket invalidSocket = INVALID_SOCKET;
+
+    struct WinsockSession {
+        WinsockSession() {
+            WSADATA data;
+            WSAStartup(MAKEWORD(2, 2), &data);
+        }
+        ~WinsockSession() {
+            WSACleanup();
+        }
+    };
+
+    void closeSocket(NativeSocket socket) {
+        closesocket(socket);
+    }
+
+    bool wouldBlock() {
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+    }
+
+    void setNonBlocking(NativeSocket socket) {
+        u_long nonBlocking = 1;
+        ioctlsocket(socket, FIONBIO, &nonBlocking);
+    }
+
+    bool connectInProgress() {
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+    }
+
+    bool waitWritable(NativeSocket socket, std::chrono::milliseconds timeout) {
+        fd_set writable;
+        FD_ZERO(&writable);
+        FD_SET(socket, &writable);
+        timeval limit{ static_cast<long>(timeout.count() / 1000), static_cast<long>(timeout.count() % 1000 * 1000) };
+        return select(0, nullptr, &writable, nullptr, &limit) == 1;
+    }
+
+    constexpr int sendFlags = 0;
+#else
+    using NativeSocket = int;
+    constexpr NativeSocket invalidSocket = -1;
+
+    void closeSocket(NativeSocket socket) {
+        ::close(socket);
+    }
+
+    bool wouldBlock() {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+
+    void setNonBlocking(NativeSocket socket) {
+        fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+    }
+
+    bool connectInProgress() {
+        return errno == EINPROGRESS;
+    }
+
+    bool waitWritable(NativeSocket socket, std::chrono::milliseconds timeout) {
+        pollfd entry{ socket, POLLOUT, 0 };
+        return poll(&entry, 1, static_cast<int>(timeout.count())) == 1;
+    }
+
+#ifdef MSG_NOSIGNAL
+    constexpr int sendFlags = MSG_NOSIGNAL;  // a closed connection is an error, not SIGPIPE
+#else
+    constexpr int sendFlags = 0;
+#endif
+#endif
+
+    NativeSocket nativeSocket(std::intptr_t handle) {
+        return static_cast<NativeSocket>(handle);
+    }
+
+    // Syslog severity of a level, with the "user" facility
+    int syslogPriority(LogLevel level) {
+        constexpr int userFacility = 1 * 8;
+        switch (level) {
+        case LogLevel::Error: return userFacility + 3;
+        case LogLevel::Warn: return userFacility + 4;
+        case LogLevel::Info: return userFacility + 6;
+        default: return userFacility + 7;
+        }
+    }
+
+    // Length of the complete records at the start of records, at most maxRecord bytes each
+    std::size_t completeRecords(std::string_view records, std::size_t headerBytes, std::size_t maxRecord, std::size_t& count) {
+        std::size_t pos = 0;
+        count = 0;
+        while (records.size() - pos >= headerBytes) {
+            std::uint32_t length;
+            std::memcpy(&length, records.data() + pos, sizeof(length));
+            if (headerBytes + length > maxRecord || records.size() - pos - headerBytes < length) {
+                break;
+            }
+            pos += headerBytes + length;
+            ++count;
+        }
+        return pos;
+    }
+
+}
+
+/**
+ * @brief Constructor for NetworkSink. Picks up lines spilled by an earlier
+ * run and starts the shipping thread, which connects in the background.
+ * @param options Protocol, address, buffer sizes and spill file.
+ */
+NetworkSink::NetworkSink(const NetworkSinkOptions& options) : options(options) {
+#ifdef _WIN32
+    static WinsockSession winsock;
+#endif
+    incoming.reserve(options.bufferBytes);
+    batch.reserve(options.bufferBytes);
+    wire.reserve(options.bufferBytes);
+    wireSource.reserve(options.bufferBytes);
+    std::error_code error;
+    std::uint64_t existing = fs::file_size(options.spillPath, error);
+    spillSize = error ? 0 : existing;
+    worker = std::thread(&NetworkSink::run, this);
+}
+
+/**
+ * @brief Destructor. Makes one last attempt to send what is buffered, then
+ * spills whatever is left so the next run can ship it.
+ */
+NetworkSink::~NetworkSink() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    wakeSignal.notify_one();
+    worker.join();
+    disconnect();
+}
+
+/**
+ * @brief Queues a finished line for shipping. Never blocks on the network:
+ * the line is copied into the buffer, or dropped and counted if it is full.
+ * @param level The severity of the line, used for the syslog priority.
+ * @param line The line as written to the log file, including its newline.
+ */
+void NetworkSink::submit(LogLevel level, std::string_view line) {
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (incoming.size() + recordHeaderBytes + line.size() > options.bufferBytes) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        wasEmpty = incoming.empty();
+        std::uint32_t length = static_cast<std::uint32_t>(line.size());
+        incoming.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        incoming += static_cast<char>(level);
+        incoming.append(line);
+    }
+    // A non-empty buffer means the shipping thread is already due to pick it up
+    if (wasEmpty) {
+        wakeSignal.notify_one();
+    }
+}
+
+/**
+ * @brief Body of the shipping thread: takes the buffered lines in one swap
+ * and ships them, until the sink is destroyed.
+ */
+void NetworkSink::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wakeSignal.wait_for(lock, idleTimeout(), [this] { return stopRequested || !incoming.empty(); });
+        batch.swap(incoming);
+        bool stopping = stopRequested;
+        lock.unlock();
+        ship();
+        batch.clear();
+        if (stopping) {
+            keepBacklog();
+            return;
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * @brief How long the shipping thread may sleep when no new lines arrive: not
+ * at all while the spill file can be replayed, briefly while the collector is
+ * not taking data, until the next reconnect attempt while disconnected, and up
+ * to a second when there is nothing to do.
+ */
+std::chrono::milliseconds NetworkSink::idleTimeout() const {
+    bool backlog = !wire.empty() || spillSize > 0;
+    if (!backlog) {
+        return std::chrono::milliseconds(1000);
+    }
+    if (socketHandle != -1) {
+        return wire.empty() ? std::chrono::milliseconds(0) : blockedRetry;
+    }
+    auto untilAttempt = std::chrono::duration_cast<std::chrono::milliseconds>(nextAttempt - std::chrono::steady_clock::now());
+    return std::clamp(untilAttempt, std::chrono::milliseconds(0), std::chrono::milliseconds(1000));
+}
+
+/**
+ * @brief Sends the current batch, or spills it if lines are still waiting
+ * ahead of it or the collector is unreachable, then replays part of the backlog.
+ */
+void NetworkSink::ship() {
+    bool connected = socketHandle != -1 || connect();
+    if (!batch.empty()) {
+        // Lines leave in the order they were logged, so a backlog makes the batch wait behind it
+        if (connected && wire.empty() && spillSize == 0) {
+            encode(batch);
+        }
+        else {
+            spill(batch);
+        }
+        batch.clear();
+    }
+    if (!connected) {
+        return;
+    }
+    // One chunk of the backlog per round, so the buffer is taken over in between
+    if (sendWire() && spillSize > 0 && loadSpilled()) {
+        sendWire();
+    }
+}
+
+/**
+ * @brief Opens the connection, waiting at most connectTimeout. After a failure
+ * the next attempt is delayed, doubling up to maxBackoffMs.
+ * @return true if connected.
+ */
+bool NetworkSink::connect() {
+    auto now = std::chrono::steady_clock::now();
+    if (now < nextAttempt) {
+        return false;
+    }
+    bool datagram = options.protocol == NetworkProtocol::Syslog;
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = datagram ? SOCK_DGRAM : SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    NativeSocket connected = invalidSocket;
+    if (getaddrinfo(options.host.c_str(), std::to_string(options.port).c_str(), &hints, &addresses) == 0) {
+        for (addrinfo* address = addresses; address != nullptr && connected == invalidSocket; address = address->ai_next) {
+            NativeSocket candidate = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (candidate == invalidSocket) {
+                continue;
+            }
+            // Non-blocking for good: connecting is bounded by connectTimeout and a send only takes what fits
+            setNonBlocking(candidate);
+            bool ok = ::connect(candidate, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0;
+            if (!ok && connectInProgress() && waitWritable(candidate, connectTimeout)) {
+                int error = 0;
+                socklen_t errorLength = sizeof(error);
+                getsockopt(candidate, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &errorLength);
+                ok = error == 0;
+            }
+            if (ok) {
+                connected = candidate;
+            }
+            else {
+                closeSocket(candidate);
+            }
+        }
+        freeaddrinfo(addresses);
+    }
+    if (connected == invalidSocket) {
+        backoff = backoff.count() == 0 ? initialBackoff : std::min(backoff * 2, std::chrono::milliseconds(options.maxBackoffMs));
+        nextAttempt = now + backoff;
+        return false;
+    }
+    socketHandle = static_cast<std::intptr_t>(connected);
+    backoff = std::chrono::milliseconds(0);
+    return true;
+}
+
+/**
+ * @brief Closes the connection. A partly sent line will be sent again from
+ * its start on the next connection.
+ */
+void NetworkSink::disconnect() {
+    if (socketHandle == -1) {
+        return;
+    }
+    closeSocket(nativeSocket(socketHandle));
+    socketHandle = -1;
+    wireSent = wireNext == 0 ? 0 : wireLines[wireNext - 1].wireEnd;
+    backoff = initialBackoff;
+    nextAttempt = std::chrono::steady_clock::now() + backoff;
+}
+
+/**
+ * @brief Sends the encoded lines: one datagram each for syslog, as a stream
+ * otherwise. Never waits: what the socket does not take now is retried on a
+ * later round, and the batches arriving meanwhile are spilled.
+ * @return true once everything encoded has been sent.
+ */
+bool NetworkSink::sendWire() {
+    NativeSocket socket = nativeSocket(socketHandle);
+    bool datagram = options.protocol == NetworkProtocol::Syslog;
+    while (wireSent < wire.size()) {
+        std::size_t end = datagram ? wireLines[wireNext].wireEnd : wire.size();
+        auto result = ::send(socket, wire.data() + wireSent, static_cast<int>(end - wireSent), sendFlags);
+        if (result < 0) {
+            if (!wouldBlock()) {
+                disconnect();
+            }
+            return false;
+        }
+        wireSent += datagram ? end - wireSent : static_cast<std::size_t>(result);
+        while (wireNext < wireLines.size() && wireLines[wireNext].wireEnd <= wireSent) {
+            ++wireNext;
+            sent.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    wire.clear();
+    wireSource.clear();
+    wireLines.clear();
+    wireSent = 0;
+    wireNext = 0;
+    return true;
+}
+
+/**
+ * @brief Converts buffered records into the protocol's wire format.
+ * @param records Records as stored by submit(); only called with wire empty.
+ */
+void NetworkSink::encode(std::string_view records) {
+    wireSource.assign(records);
+    std::size_t pos = 0;
+    while (pos + recordHeaderBytes <= records.size()) {
+        std::uint32_t length;
+        std::memcpy(&length, records.data() + pos, sizeof(length));
+        LogLevel level = static_cast<LogLevel>(records[pos + sizeof(length)]);
+        std::string_view line = records.substr(pos + recordHeaderBytes, length);
+        pos += recordHeaderBytes + length;
+        if (line.ends_with('\n')) {
+            line.remove_suffix(1);
+        }
+        switch (options.protocol) {
+        case NetworkProtocol::Syslog: {
+            char priority[8];
+            int priorityLength = std::snprintf(priority, sizeof(priority), "<%d>", syslogPriority(level));
+            wire.append(priority, priorityLength);
+            wire.append(line.substr(0, maxDatagramLine));
+            break;
+        }
+        case NetworkProtocol::Framed: {
+            std::uint32_t size = static_cast<std::uint32_t>(line.size());
+            char prefix[4] = { static_cast<char>(size >> 24), static_cast<char>(size >> 16), static_cast<char>(size >> 8), static_cast<char>(size) };
+            wire.append(prefix, sizeof(prefix));
+            wire.append(line);
+            break;
+        }
+        default:
+            wire.append(line);
+            wire += '\n';
+            break;
+        }
+        wireLines.push_back({ wire.size(), pos });
+    }
+}
+
+/**
+ * @brief Appends records to the spill file, or drops them if spilling is
+ * disabled or the spill budget is used up.
+ * @param records Records as stored by submit().
+ */
+void NetworkSink::spill(std::string_view records) {
+    std::size_t count;
+    std::size_t length = completeRecords(records, recordHeaderBytes, options.bufferBytes, count);
+    if (count == 0) {
+        return;
+    }
+    if (options.spillBytes > 0 && spillSize + length <= options.spillBytes) {
+        std::ofstream out(options.spillPath, std::ios::binary | std::ios::app);
+        if (out.write(records.data(), static_cast<std::streamsize>(length))) {
+            spillSize += length;
+            return;
+        }
+    }
+    dropped.fetch_add(count, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Encodes the next part of the spill file, up to one buffer's worth.
+ * The file is emptied once everything in it has been taken.
+ * @return true if lines were loaded.
+ */
+bool NetworkSink::loadSpilled() {
+    std::ifstream in(options.spillPath, std::ios::binary);
+    std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(spillSize - spillOffset, options.bufferBytes));
+    batch.resize(chunk);
+    in.seekg(static_cast<std::streamoff>(spillOffset));
+    std::size_t count = 0;
+    std::size_t length = in.read(batch.data(), static_cast<std::streamsize>(chunk))
+        ? completeRecords(batch, recordHeaderBytes, options.bufferBytes, count) : 0;
+    in.close();
+    if (length == 0) {
+        // Unreadable or damaged: nothing more can be replayed from it
+        length = static_cast<std::size_t>(spillSize - spillOffset);
+    }
+    else {
+        encode(std::string_view(batch).substr(0, length));
+    }
+    batch.clear();
+    spillOffset += length;
+    if (spillOffset >= spillSize) {
+        std::error_code error;
+        fs::resize_file(options.spillPath, 0, error);
+        spillSize = 0;
+        spillOffset = 0;
+    }
+    return count > 0;
+}
+
+/**
+ * @brief Leaves everything not sent yet in the spill file for the next run:
+ * the lines that were being sent, followed by the part of the spill file that
+ * was not replayed. The file is rewritten through a temporary file when lines
+ * were replayed from it, so they are not sent twice, or when sending was
+ * interrupted, so the interrupted lines stay ahead of the rest. Like spill(),
+ * the interrupted lines are dropped and counted if spilling is disabled or
+ * the spill budget has no room for them.
+ */
+void NetworkSink::keepBacklog() {
+    std::string_view unsent;
+    if (wireNext < wireLines.size()) {
+        std::size_t sourceStart = wireNext == 0 ? 0 : wireLines[wireNext - 1].sourceEnd;
+        unsent = std::string_view(wireSource).substr(sourceStart);
+    }
+    if (!unsent.empty()) {
+        // Same rule as spill(): the lines are dropped if spilling is disabled or they would exceed the budget
+        std::size_t count;
+        std::size_t length = completeRecords(unsent, recordHeaderBytes, options.bufferBytes, count);
+        if (options.spillBytes == 0 || spillSize - spillOffset + length > options.spillBytes) {
+            dropped.fetch_add(count, std::memory_order_relaxed);
+            length = 0;
+        }
+        unsent = unsent.substr(0, length);
+    }
+    if (unsent.empty() && spillOffset == 0) {
+        return;
+    }
+    fs::path temporary = options.spillPath;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(unsent.data(), static_cast<std::streamsize>(unsent.size()));
+        if (spillOffset < spillSize) {
+            std::ifstream in(options.spillPath, std::ios::binary);
+            in.seekg(static_cast<std::streamoff>(spillOffset));
+            out << in.rdbuf();
+        }
+        if (!out) {
+            return;
+        }
+    }
+    std::error_code error;
+    fs::rename(temporary, options.spillPath, error);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "LogLevel.h"
+
+enum class NetworkProtocol {
+    None,    // no network sink
+    Syslog,  // one UDP datagram per line, prefixed with a syslog priority ("<14>...")
+    Tcp,     // newline-terminated lines over TCP
+    Framed   // TCP, each line preceded by its length as a 4-byte big-endian integer
+};
+
+struct NetworkSinkOptions {
+    NetworkProtocol protocol = NetworkProtocol::None;
+    std::string host = "127.0.0.1";
+    std::uint16_t port = 514;
+    std::size_t bufferBytes = 1024 * 1024;       // lines waiting to be shipped
+    std::uint64_t spillBytes = 64ull * 1024 * 1024;  // on-disk backlog while the remote is unreachable or slow; 0 drops instead
+    int maxBackoffMs = 30000;                     // longest wait between reconnect attempts
+    std::filesystem::path spillPath;
+};
+
+/**
+ * @brief Ships finished log lines to a remote collector from a thread of its own.
+ * submit() only copies the line into a bounded buffer that was allocated up
+ * front, so logging never waits for the network. The shipping thread sends
+ * what has accumulated in one batch. While the collector is unreachable, or
+ * has not taken the previous batch yet, batches are appended to a spill file
+ * instead and replayed in order once it catches up; what is left unsent at
+ * shutdown stays in the spill file for the next run. Lines are only dropped when both the buffer and the
+ * spill budget are full.
+ */
+class NetworkSink {
+public:
+    explicit NetworkSink(const NetworkSinkOptions& options);
+    ~NetworkSink();
+    NetworkSink(const NetworkSink&) = delete;
+    NetworkSink& operator=(const NetworkSink&) = delete;
+
+    void submit(LogLevel level, std::string_view line);
+
+    std::uint64_t sentCount() const { return sent.load(std::memory_order_relaxed); }
+    std::uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    // Buffered lines are stored as [4-byte length][1-byte level][line], in memory and in the spill file
+    static constexpr std::size_t recordHeaderBytes = 5;
+
+    NetworkSinkOptions options;
+    std::mutex mutex;
+    std::condition_variable wakeSignal;
+    std::string incoming;  // guarded by mutex
+    bool stopRequested = false;
+    std::atomic<std::uint64_t> sent{ 0 };
+    std::atomic<std::uint64_t> dropped{ 0 };
+
+    // Shipping thread only
+    struct WireLine {
+        std::size_t wireEnd;    // end of the line in wire
+        std::size_t sourceEnd;  // end of its record in wireSource
+    };
+    std::string batch;
+    std::string wire;                     // the lines being sent, in the wire format
+    std::string wireSource;               // the same lines as buffered records, spilled if shutdown interrupts sending
+    std::vector<WireLine> wireLines;
+    std::size_t wireSent = 0;             // bytes of wire already sent
+    std::size_t wireNext = 0;             // first line of wire not completely sent
+    std::intptr_t socketHandle = -1;
+    std::chrono::steady_clock::time_point nextAttempt;
+    std::chrono::milliseconds backoff{ 0 };
+    std::uint64_t spillSize = 0;          // bytes in the spill file, replayed from spillOffset
+    std::uint64_t spillOffset = 0;
+    std::thread worker;
+
+    void run();
+    void ship();
+    bool connect();
+    void disconnect();
+    bool sendWire();
+    std::chrono::milliseconds idleTimeout() const;
+    void encode(std::string_view records);
+    void spill(std::string_view records);
+    bool loadSpilled();
+    void keepBacklog();
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief A fixed number of equally sized blocks carved out of one allocation
+ * and handed out through a lock-free free list. Any thread may acquire a block
+ * and any thread may release it, so a producer can fill a block and the writer
+ * thread give it back once the record that uses it is written.
+ * The list head pairs the index of the first free block with a generation
+ * count that changes on every update, so a block that is taken and returned
+ * between another thread's read of the head and its exchange cannot corrupt
+ * the list (the ABA problem).
+ */
+class SlabPool {
+public:
+    /**
+     * @param slabBytes Size of each block.
+     * @param slabCount Number of blocks; all memory is allocated here.
+     */
+    SlabPool(std::size_t slabBytes, std::size_t slabCount)
+        : slabSize(slabBytes), slabTotal(static_cast<std::uint32_t>(slabCount)),
+        storage(std::make_unique<char[]>(slabBytes * slabCount)),
+        nextFree(std::make_unique<std::atomic<std::uint32_t>[]>(slabCount)) {
+        for (std::uint32_t i = 0; i < slabTotal; ++i) {
+            nextFree[i].store(i + 1, std::memory_order_relaxed);
+        }
+        head.store(pack(0, 0), std::memory_order_relaxed);
+    }
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    /**
+     * @brief Takes a free block.
+     * @return The block, or nullptr if all of them are in use.
+     */
+    char* acquire() {
+        std::uint64_t current = head.load(std::memory_order_acquire);
+        for (;;) {
+            std::uint32_t index = indexOf(current);
+            if (index == slabTotal) {
+                return nullptr;
+            }
+            std::uint64_t replacement = pack(nextFree[index].load(std::memory_order_relaxed), generationOf(current) + 1);
+            if (head.compare_exchange_weak(current, replacement, std::memory_order_acquire, std::memory_order_acquire)) {
+                return storage.get() + static_cast<std::size_t>(index) * slabSize;
+            }
+        }
+    }
+
+    /**
+     * @brief Returns a block taken with acquire().
+     */
+    void release(char* slab) {
+        auto index = static_cast<std::uint32_t>(static_cast<std::size_t>(slab - storage.get()) / slabSize);
+        std::uint64_t current = head.load(std::memory_order_relaxed);
+        do {
+            nextFree[index].store(indexOf(current), std::memory_order_relaxed);
+        } while (!head.compare_exchange_weak(current, pack(index, generationOf(current) + 1),
+            std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    std::size_t slabBytes() const { return slabSize; }
+
+private:
+    std::size_t slabSize;
+    std::uint32_t slabTotal;                              // also the index that ends the free list
+    std::unique_ptr<char[]> storage;
+    std::unique_ptr<std::atomic<std::uint32_t>[]> nextFree;  // free list link of every block
+    std::atomic<std::uint64_t> head{ 0 };                 // generation in the high half, first free block in the low half
+
+    static std::uint64_t pack(std::uint32_t index, std::uint32_t generation) {
+        return static_cast<std::uint64_t>(generation) << 32 | index;
+    }
+    static std::uint32_t indexOf(std::uint64_t value) { return static_cast<std::uint32_t>(value); }
+    static std::uint32_t generationOf(std::uint64_t value) { return static_cast<std::uint32_t>(value >> 32); }
+};
@@ -0,0 +1,130 @@
+#include "TimestampCache.h"
+
+#include <cstdint>
+
+namespace {
+
+    void writeDigits(char* out, unsigned value, int count) {
+        for (int i = count - 1; i >= 0; --i) {
+            out[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+    // Days since 1970-01-01 of a proleptic Gregorian date (month 1-12)
+    std::int64_t daysFromCivil(std::int64_t year, unsigned month, unsigned day) {
+        year -= month <= 2;
+        std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+        auto yearOfEra = static_cast<unsigned>(year - era * 400);
+        unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + static_cast<std::int64_t>(dayOfEra) - 719468;
+    }
+
+    // Seconds since the epoch of a broken-down time read as UTC
+    std::time_t secondsFromCivil(const std::tm& time) {
+        std::int64_t days = daysFromCivil(time.tm_year + 1900, static_cast<unsigned>(time.tm_mon + 1), static_cast<unsigned>(time.tm_mday));
+        return static_cast<std::time_t>(days * 86400 + time.tm_hour * 3600 + time.tm_min * 60 + time.tm_sec);
+    }
+
+    // Fills the date and time fields of out from seconds since the epoch, read as UTC
+    void civilFromSeconds(std::time_t seconds, std::tm& out) {
+        std::int64_t days = seconds / 86400;
+        std::int64_t secondOfDay = seconds % 86400;
+        if (secondOfDay < 0) {
+            secondOfDay += 86400;
+            --days;
+        }
+        out.tm_hour = static_cast<int>(secondOfDay / 3600);
+        out.tm_min = static_cast<int>(secondOfDay / 60 % 60);
+        out.tm_sec = static_cast<int>(secondOfDay % 60);
+        out.tm_wday = static_cast<int>((days % 7 + 11) % 7);  // 1970-01-01 was a Thursday
+
+        std::int64_t shifted = days + 719468;
+        std::int64_t era = (shifted >= 0 ? shifted : shifted - 146096) / 146097;
+        auto dayOfEra = static_cast<unsigned>(shifted - era * 146097);
+        unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+        unsigned day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+        unsigned month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+        std::int64_t year = static_cast<std::int64_t>(yearOfEra) + era * 400 + (month <= 2);
+        out.tm_year = static_cast<int>(year - 1900);
+        out.tm_mon = static_cast<int>(month - 1);
+        out.tm_mday = static_cast<int>(day);
+        out.tm_yday = static_cast<int>(days - daysFromCivil(year, 1, 1));
+    }
+
+}
+
+/**
+ * @brief Returns the formatted timestamp for the given time.
+ * The returned view points into the cache and stays valid until the next call.
+ * @param time The time to format.
+ * @param precision Number of sub-second digits to append.
+ * @return The formatted timestamp.
+ */
+std::string_view TimestampCache::format(std::chrono::system_clock::time_point time, TimestampPrecision precision) {
+    auto sinceEpoch = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch());
+    auto seconds = std::chrono::floor<std::chrono::seconds>(sinceEpoch);
+    std::time_t second = static_cast<std::time_t>(seconds.count());
+    if (second != cachedSecond) {
+        refresh(second);
+    }
+
+    unsigned micros = static_cast<unsigned>((sinceEpoch - seconds).count());
+    switch (precision) {
+    case TimestampPrecision::Milliseconds:
+        writeDigits(buffer + secondsLength + 1, micros / 1000, 3);
+        return std::string_view(buffer, secondsLength + 4);
+    case TimestampPrecision::Microseconds:
+        writeDigits(buffer + secondsLength + 1, micros, 6);
+        return std::string_view(buffer, secondsLength + 7);
+    default:
+        return std::string_view(buffer, secondsLength);
+    }
+}
+
+/**
+ * @brief Converts a time to local time with the platform's thread-safe function.
+ * @param time Seconds since the epoch.
+ * @param out Receives the broken-down local time.
+ */
+void TimestampCache::toLocalTime(std::time_t time, std::tm& out) {
+#ifdef _WIN32
+    localtime_s(&out, &time);
+#else
+    localtime_r(&time, &out);
+#endif
+}
+
+/**
+ * @brief Rebuilds the "YYYY-MM-DD HH:MM:SS." prefix for a new second.
+ * @param second The new second as a time_t value.
+ */
+void TimestampCache::refresh(std::time_t second) {
+    std::time_t periodStart = second - ((second % offsetPeriod) + offsetPeriod) % offsetPeriod;
+    if (periodStart != offsetPeriodStart) {
+        toLocalTime(second, cachedTime);
+        utcOffset = secondsFromCivil(cachedTime) - second;
+        isDst = cachedTime.tm_isdst;
+        offsetPeriodStart = periodStart;
+    }
+    else {
+        civilFromSeconds(second + utcOffset, cachedTime);
+        cachedTime.tm_isdst = isDst;
+    }
+    cachedSecond = second;
+    writeDigits(buffer, static_cast<unsigned>(cachedTime.tm_year + 1900), 4);
+    buffer[4] = '-';
+    writeDigits(buffer + 5, static_cast<unsigned>(cachedTime.tm_mon + 1), 2);
+    buffer[7] = '-';
+    writeDigits(buffer + 8, static_cast<unsigned>(cachedTime.tm_mday), 2);
+    buffer[10] = ' ';
+    writeDigits(buffer + 11, static_cast<unsigned>(cachedTime.tm_hour), 2);
+    buffer[13] = ':';
+    writeDigits(buffer + 14, static_cast<unsigned>(cachedTime.tm_min), 2);
+    buffer[16] = ':';
+    writeDigits(buffer + 17, static_cast<unsigned>(cachedTime.tm_sec), 2);
+    buffer[secondsLength] = '.';
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <string_view>
+
+enum class TimestampPrecision {
+    Seconds,       // 2024-01-31 12:34:56
+    Milliseconds,  // 2024-01-31 12:34:56.789
+    Microseconds   // 2024-01-31 12:34:56.789012
+};
+
+/**
+ * @brief Formats log line timestamps without going through localtime/put_time per call.
+ * The "YYYY-MM-DD HH:MM:SS" prefix is rebuilt only when the second changes; the
+ * sub-second digits are patched in place. The local time for a new second is
+ * derived from a cached UTC offset, which is looked up again at most once per
+ * quarter hour: time zone offsets and DST transitions fall on quarter-hour
+ * boundaries. An instance is not thread-safe and is meant to be kept per thread.
+ */
+class TimestampCache {
+public:
+    std::string_view format(std::chrono::system_clock::time_point time, TimestampPrecision precision);
+    const std::tm& localTime() const { return cachedTime; }
+    static void toLocalTime(std::time_t time, std::tm& out);
+
+private:
+    static constexpr std::size_t secondsLength = 19;
+    static constexpr std::time_t offsetPeriod = 15 * 60;
+
+    std::time_t cachedSecond = -1;
+    std::tm cachedTime{};
+    char buffer[32]{};
+    std::time_t offsetPeriodStart = -1;  // quarter hour the cached offset was looked up for
+    std::time_t utcOffset = 0;           // local time minus UTC, in seconds
+    int isDst = 0;
+
+    void refresh(std::time_t second);
+};
@@ -0,0 +1,126 @@
+#include "WriterThread.h"
+#include "CircularLogger.h"
+
+#include <algorithm>
+
+/**
+ * @brief Destructor. Stops the thread once every attached logger has detached.
+ */
+WriterThread::~WriterThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    wakeSignal.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Starts writing the queue of logger, starting the thread if needed.
+ * @param logger An asynchronous logger; it must call detach() before it is destroyed.
+ */
+void WriterThread::attach(CircularLogger& logger) {
+    std::lock_guard<std::mutex> lock(mutex);
+    loggers.push_back(&logger);
+    if (!worker.joinable()) {
+        worker = std::thread(&WriterThread::run, this);
+    }
+    wakeSignal.notify_one();
+}
+
+/**
+ * @brief Writes everything logger has queued, flushes its file and stops
+ * serving it. Blocks until the thread has let go of the logger.
+ * @param logger A logger passed to attach(); no thread may log to it any more.
+ */
+void WriterThread::detach(CircularLogger& logger) {
+    std::unique_lock<std::mutex> lock(mutex);
+    leaving.push_back(&logger);
+    wakeSignal.notify_one();
+    progress.wait(lock, [&] { return std::find(loggers.begin(), loggers.end(), &logger) == loggers.end(); });
+}
+
+/**
+ * @brief Blocks until the thread has written and flushed logger's messages up
+ * to target, the logger's count of accepted messages when the flush began.
+ * @param logger An attached logger.
+ * @param target Number of accepted messages that must be on disk.
+ */
+void WriterThread::flush(CircularLogger& logger, std::uint64_t target) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (target > logger.flushTarget) {
+        logger.flushTarget = target;
+    }
+    wakeSignal.notify_one();
+    progress.wait(lock, [&] { return logger.flushedCount >= target; });
+}
+
+/**
+ * @brief Returns true if an attached logger has queued messages or waits for
+ * a flush, or a logger waits to be detached. Must be called with mutex held.
+ */
+bool WriterThread::hasWork() const {
+    if (!leaving.empty()) {
+        return true;
+    }
+    return std::any_of(loggers.begin(), loggers.end(), [](const CircularLogger* logger) {
+        return !logger->queue->empty() || logger->flushTarget > logger->flushedCount;
+    });
+}
+
+/**
+ * @brief Body of the writer thread. Drains every attached queue in batches
+ * and after each round services the flush requests whose messages have been
+ * written and the detaching loggers whose queues are empty, so neither waits
+ * for the other loggers to go quiet. Sleeps when no queue has work.
+ */
+void WriterThread::run() {
+    std::vector<CircularLogger*> active;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        // Loggers are only removed by this thread, so the copy stays valid unlocked
+        active.assign(loggers.begin(), loggers.end());
+        lock.unlock();
+        std::size_t drained = 0;
+        for (CircularLogger* logger : active) {
+            drained += logger->drainQueue();
+        }
+        lock.lock();
+
+        for (auto it = loggers.begin(); it != loggers.end();) {
+            CircularLogger* logger = *it;
+            auto leavingEntry = std::find(leaving.begin(), leaving.end(), logger);
+            if (leavingEntry != leaving.end() && logger->queue->empty()) {
+                logger->completeFlush();
+                leaving.erase(leavingEntry);
+                it = loggers.erase(it);
+                progress.notify_all();
+                continue;
+            }
+            if (logger->serviceFlush()) {
+                progress.notify_all();
+            }
+            ++it;
+        }
+        if (stopRequested && loggers.empty()) {
+            break;
+        }
+        if (drained > 0) {
+            continue;
+        }
+
+        // Wake up periodically so the interval flush policy is honoured while idle
+        auto idleTimeout = std::chrono::milliseconds(100);
+        for (const CircularLogger* logger : loggers) {
+            idleTimeout = std::min(idleTimeout, logger->idleTimeout());
+        }
+        sleeping.store(true);
+        wakeSignal.wait_for(lock, idleTimeout, [this] { return hasWork() || (stopRequested && loggers.empty()); });
+        sleeping.store(false);
+        for (CircularLogger* logger : loggers) {
+            logger->flushOnInterval();
+        }
+    }
+}
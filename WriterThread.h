@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class CircularLogger;
+
+/**
+ * @brief Background thread that writes the queued messages of one or more
+ * asynchronous loggers. The attached loggers are drained in turn, so their
+ * disk writes run one after another instead of competing for the disk from
+ * separate threads. The thread starts with the first attached logger.
+ */
+class WriterThread {
+public:
+    WriterThread() = default;
+    ~WriterThread();
+    WriterThread(const WriterThread&) = delete;
+    WriterThread& operator=(const WriterThread&) = delete;
+
+    void attach(CircularLogger& logger);
+    void detach(CircularLogger& logger);
+    void flush(CircularLogger& logger, std::uint64_t target);
+
+    /**
+     * @brief Wakes the thread if it is waiting for work.
+     * The mutex is only taken when the thread is actually asleep, so producers
+     * running against a busy writer never touch it.
+     */
+    void wake() {
+        if (sleeping.load()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            wakeSignal.notify_one();
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable wakeSignal;
+    std::condition_variable progress;      // a flush completed or a logger was detached
+    std::atomic<bool> sleeping{ false };
+    bool stopRequested = false;
+    std::vector<CircularLogger*> loggers;  // attached loggers, guarded by mutex
+    std::vector<CircularLogger*> leaving;  // loggers waiting in detach(), guarded by mutex
+    std::thread worker;
+
+    void run();
+    bool hasWork() const;
+};